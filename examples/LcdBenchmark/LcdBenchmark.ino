@@ -0,0 +1,99 @@
+/*
+ * LCD Benchmark
+ * Measure how long it takes to update a WeatherStation-like dashboard
+ * on the LCD, writing everything directly and through the shadow buffer.
+ *
+ * Results are sent to the serial port at 115200 baud. Uncomment
+ * __LCD_STATISTICS__ in LiquidCrystal.h to also get the number of bytes
+ * and the modeled HD44780 bus time per frame. extras/host replays the
+ * same dashboard on a simulated HD44780 without hardware (make bench).
+ *
+ * For use with PolyValens Multipurpose Shield 129009-1
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <MultipurposeShield.h>
+
+MultipurposeShield mps(hasLcd);
+
+#define FRAMES  20
+
+
+// Draw one frame of the dashboard. Only the light level changes from
+// frame to frame, like it does most of the time in the weather station.
+void drawFrame(uint8_t frame)
+{
+  mps.lcd.setCursor(0,0);
+  mps.lcd.print(" t  rh  mbar lum");
+  mps.lcd.setCursor(0,1);
+  mps.lcd.printField(21,2);
+  mps.lcd.write(0xdf);
+  mps.lcd.print(' ');
+  mps.lcd.printField(45,2,"%");
+  mps.lcd.print(' ');
+  mps.lcd.printField(1013,4);
+  mps.lcd.print(' ');
+  mps.lcd.printField(50+frame%10,2,"%");
+}
+
+
+void benchmark(const char *name, boolean shadow)
+{
+  mps.lcd.clear();
+  if (shadow==true) mps.lcd.shadowBuffer();
+#ifdef __LCD_STATISTICS__
+  mps.lcd.resetStatistics();
+#endif /* __LCD_STATISTICS__ */
+
+  uint32_t t = micros();
+  for (uint8_t i=0; i<FRAMES; i++)
+  {
+    drawFrame(i);
+    mps.lcd.flush();
+  }
+  t = micros() - t;
+
+  if (shadow==true) mps.lcd.noShadowBuffer();
+
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(t/FRAMES);
+  Serial.print(" us/frame");
+#ifdef __LCD_STATISTICS__
+  const LcdStatistics& s = mps.lcd.statistics();
+  Serial.print(", ");
+  Serial.print((float)(s.commands+s.data)/FRAMES,1);
+  Serial.print(" bytes/frame, ");
+  Serial.print(s.bus_us/FRAMES);
+  Serial.print(" us bus time/frame");
+#endif /* __LCD_STATISTICS__ */
+  Serial.println();
+}
+
+
+void setup(void)
+{
+  Serial.begin(115200);
+  mps.begin();
+  benchmark("direct",false);
+  benchmark("shadow",true);
+}
+
+
+void loop(void)
+{
+}
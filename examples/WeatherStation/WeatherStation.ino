@@ -40,120 +40,137 @@ MultipurposeShield mps(hasLcd |
 
 #define __CELSIUS__
 
-// Custom degree character.
-uint8_t degree[8] = 
+// Custom characters.
+enum
 {
+  glyphDegree,
+};
+
+const LcdGlyph glyphs[] PROGMEM =
+{
+  // Degree character, falls back on the ROM degree sign.
+  {
+    {
 #ifdef __CELSIUS__
-  0b11100,
-  0b10100,
-  0b11100,
-  0b00000,
-  0b00011,
-  0b00100,
-  0b00100,
-  0b00011
+      0b11100,
+      0b10100,
+      0b11100,
+      0b00000,
+      0b00011,
+      0b00100,
+      0b00100,
+      0b00011
 #else
-  0b11100,
-  0b10100,
-  0b11100,
-  0b00000,
-  0b00111,
-  0b00100,
-  0b00110,
-  0b00100
+      0b11100,
+      0b10100,
+      0b11100,
+      0b00000,
+      0b00111,
+      0b00100,
+      0b00110,
+      0b00100
 #endif /* __CELSIUS__ */
+    },
+    0xdf
+  },
 };
 
-
-void setup(void)
-{
-  mps.begin();
-  mps.lcd.print("Weather Station");
-  delay(1500);
-  // Create special degree character to save display space.
-  mps.lcd.createChar(0,degree);
-  mps.lcd.clear();
-  // Note: "lum" does not mean "lumen", that would be "lm".
-  //            "0123456789012345"
-  mps.lcd.print(" t  rh  mbar lum"); 
-}
+// Loads the custom characters in the LCD when they are needed.
+LcdGlyphCache glyph(mps.lcd,glyphs,sizeof(glyphs)/sizeof(glyphs[0]));
 
 
-void loop(void)
+void show(void)
 {
-  static uint32_t t_last = 0;
-  
+  // LED2 on.
+  mps.led2Write(HIGH);
+
   // Read the light sensor.
   uint16_t light = mps.lightSensorRead();
 
-  // Every 1000 ms do...
-  if (millis()>t_last+1000)
-  {
-    t_last = millis();
-
-    // LED2 on.
-    mps.led2Write(HIGH);
-    
-    // Read the pressure sensor.
-    // The correction value of 23 depends on your location.
-    // First set to 0 and compare the displayed value with a
-    // reference value obtained from another source (internet),
-    // then calculate the difference and use that in place of 23.
-    // The correction may be positive or negative.
-    int p = mps.pressureSensorRead(23);
-    
-    // Read the humidity sensor twice as it provides relative
-    // humidity and temperature.
-    float rh = mps.humiditySensorReadRh();
-    float t = mps.humiditySensorReadT();
+  // Read the pressure sensor.
+  // The correction value of 23 depends on your location.
+  // First set to 0 and compare the displayed value with a
+  // reference value obtained from another source (internet),
+  // then calculate the difference and use that in place of 23.
+  // The correction may be positive or negative.
+  int p = mps.pressureSensorRead(23);
+  
+  // The humidity sensor provides relative humidity and
+  // temperature, both come from the same measurement. Integer
+  // hundredths keep the float printing code out of the sketch.
+  int16_t t;
+  uint8_t status = mps.humiditySensorReadTCenti(t);
+  uint16_t rh = mps.sht11.get_humidity_centi();
 
 #ifndef __CELSIUS__
-    t = t*9.0/5.0 + 32.0; // Celsius to Fahrenheit.
+  t = (int32_t)t*9/5 + 3200; // Celsius to Fahrenheit.
 #endif /* __CELSIUS__ */
 
-    // Show results.
-    mps.lcd.setCursor(0,1);
-    
-    // Print temperature, right justified.
-    t += 0.5; // For rounding.
-    // There is not enough space on the display for 3-digit values.
-    if (t>99.0) t = 99.0;
-    if (t>=0.0 && t<10.0) mps.lcd.print(' '); // Negative values need an extra position.
-    mps.lcd.print(t,0); // Print without decimals.
-    mps.lcd.write((uint8_t)0); // Print our special degree symbol.
+  // Show results.
+  mps.lcd.setCursor(0,1);
 
-    // Print separator.
-    mps.lcd.print(' ');
-    
-    // Print relative humidity, right justified.
-    rh += 0.5; // For rounding.
-    // There is not enough space on the display for 3-digit values.
-    if (rh>99.0) rh = 99.0;
-    if (rh<10.0) mps.lcd.print(' ');
-    mps.lcd.print(rh,0); // Print without decimals.
-    mps.lcd.print("%");
-    
-    // Print separator.
-    mps.lcd.print(' ');
+  if (status!=statusOk)
+  {
+    mps.lcd.print("--");
+    glyph.write(glyphDegree);
+    mps.lcd.print(" --%");
+  }
+  else
+  {
+    // Print temperature without decimals, rounded and right justified.
+    // There is not enough space on the display for 3-digit values,
+    // printFixed clamps them to 2 digits.
+    mps.lcd.printFixed(t,2,2);
+    glyph.write(glyphDegree); // Print our special degree symbol.
 
-    // Print atmospheric pressure, right justified.
-    if (p<1000) mps.lcd.print(' ');
-    if (p<100) mps.lcd.print(' '); // Very, very bad weather.
-    if (p<10) mps.lcd.print(' '); // End of the world.
-    mps.lcd.print(p);
-    
     // Print separator.
     mps.lcd.print(' ');
-    
-    // Print luminosity, right justified.
-    // There is not enough space on the display for 3-digit values.
-    if (light>99) light = 99;
-    if (light<10) mps.lcd.print(' ');
-    mps.lcd.print(light);
-    mps.lcd.print("%");
-
-    // LED2 off.
-    mps.led2Write(LOW);
+
+    // Print relative humidity the same way.
+    mps.lcd.printFixed(rh,2,2,0,"%");
   }
+  
+  // Print separator.
+  mps.lcd.print(' ');
+
+  // Print atmospheric pressure, right justified.
+  mps.lcd.printField(p,4);
+  
+  // Print separator.
+  mps.lcd.print(' ');
+  
+  // Print luminosity, right justified.
+  // There is not enough space on the display for 3-digit values,
+  // printField clamps 100 to 99.
+  mps.lcd.printField(light,2,"%");
+
+  // Send the changes to the display.
+  mps.lcd.flush();
+
+  // LED2 off.
+  mps.led2Write(LOW);
 }
 
+
+void setup(void)
+{
+  mps.begin();
+  mps.lcd.print("Weather Station");
+  delay(1500);
+  mps.lcd.clear();
+  // Note: "lum" does not mean "lumen", that would be "lm".
+  //            "0123456789012345"
+  mps.lcd.print(" t  rh  mbar lum"); 
+  // From now on only send the characters that actually change.
+  mps.lcd.shadowBuffer();
+  // Measure humidity & temperature every 1000 ms and show the results
+  // when they are ready. The measurement takes about 400 ms, run() does
+  // it in small steps.
+  mps.schedule(hasHumiditySensor,1000,show);
+}
+
+
+void loop(void)
+{
+  mps.run();
+}
@@ -0,0 +1,234 @@
+/*
+ * Host build of the Multipurpose Shield library, simulated Uno core.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include "Arduino.h"
+
+
+HostRegister DDRB, PORTB, PINB;
+HostRegister DDRC, PORTC, PINC;
+HostRegister DDRD, PORTD, PIND;
+HostRegister SREG(SREG_I); // init() enables interrupts
+HostRegister TWCR, TWSR, TWDR, TWBR, TWAR;
+
+HardwareSerial Serial;
+
+static unsigned long now_us = 0;
+static HostDevice *devices = 0;
+static boolean syncing = false;
+
+
+HostDevice::HostDevice(void) : _next(devices)
+{
+  devices = this;
+}
+
+
+HostDevice::~HostDevice(void)
+{
+  HostDevice **p = &devices;
+  while (*p!=this) p = &(*p)->_next;
+  *p = _next;
+}
+
+
+// Inputs read 1, as if every pin had a pull-up, then the devices drive
+// their pins.
+void hostSync(void)
+{
+  if (syncing==true) return;
+  syncing = true;
+  PINB._value = PORTB._value | ~DDRB._value;
+  PINC._value = PORTC._value | ~DDRC._value;
+  PIND._value = PORTD._value | ~DDRD._value;
+  for (HostDevice *device=devices; device!=0; device=device->_next)
+  {
+    device->sync(now_us);
+  }
+  syncing = false;
+}
+
+
+void hostInterrupt(void (*vector)(void))
+{
+  boolean was = syncing;
+  syncing = false;
+  vector();
+  syncing = was;
+}
+
+
+unsigned long hostMicros(void)
+{
+  return now_us;
+}
+
+
+void hostElapse(unsigned long us)
+{
+  hostSync();
+  now_us += us;
+  hostSync();
+}
+
+
+volatile uint8_t *portOutputRegister(uint8_t port)
+{
+  if (port==PB) return &PORTB._value;
+  if (port==PC) return &PORTC._value;
+  if (port==PD) return &PORTD._value;
+  return 0;
+}
+
+
+volatile uint8_t *portInputRegister(uint8_t port)
+{
+  if (port==PB) return &PINB._value;
+  if (port==PC) return &PINC._value;
+  if (port==PD) return &PIND._value;
+  return 0;
+}
+
+
+volatile uint8_t *portModeRegister(uint8_t port)
+{
+  if (port==PB) return &DDRB._value;
+  if (port==PC) return &DDRC._value;
+  if (port==PD) return &DDRD._value;
+  return 0;
+}
+
+
+int8_t hostPinDriven(uint8_t pin)
+{
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  if (port==NOT_A_PORT || (*portModeRegister(port)&mask)==0) return -1;
+  return (*portOutputRegister(port)&mask)!=0;
+}
+
+
+void hostPinInput(uint8_t pin, uint8_t level)
+{
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  if (port==NOT_A_PORT || (*portModeRegister(port)&mask)!=0) return;
+  if (level!=0) *portInputRegister(port) |= mask;
+  else *portInputRegister(port) &= ~mask;
+}
+
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  now_us += HOST_PIN_US;
+  if (port==NOT_A_PORT) return;
+  if (mode==OUTPUT) *portModeRegister(port) |= mask;
+  else
+  {
+    *portModeRegister(port) &= ~mask;
+    if (mode==INPUT_PULLUP) *portOutputRegister(port) |= mask;
+    else *portOutputRegister(port) &= ~mask;
+  }
+  hostSync();
+}
+
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  now_us += HOST_PIN_US;
+  if (port==NOT_A_PORT) return;
+  if (value!=LOW) *portOutputRegister(port) |= mask;
+  else *portOutputRegister(port) &= ~mask;
+  hostSync();
+}
+
+
+int digitalRead(uint8_t pin)
+{
+  uint8_t port = digitalPinToPort(pin);
+  uint8_t mask = digitalPinToBitMask(pin);
+  now_us += HOST_PIN_US;
+  if (port==NOT_A_PORT) return LOW;
+  hostSync();
+  return (*portInputRegister(port)&mask)!=0? HIGH : LOW;
+}
+
+
+// Nothing is connected to the analog inputs.
+int analogRead(uint8_t pin)
+{
+  now_us += 112; // 13 ADC clocks at 125 kHz
+  return 0;
+}
+
+
+void analogWrite(uint8_t pin, int value)
+{
+  pinMode(pin,OUTPUT);
+  digitalWrite(pin,value>=128? HIGH : LOW);
+}
+
+
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration)
+{
+}
+
+
+void noTone(uint8_t pin)
+{
+}
+
+
+unsigned long millis(void)
+{
+  now_us += HOST_CLOCK_US;
+  hostSync();
+  return now_us/1000;
+}
+
+
+unsigned long micros(void)
+{
+  now_us += HOST_CLOCK_US;
+  hostSync();
+  return now_us;
+}
+
+
+void delay(unsigned long ms)
+{
+  hostElapse(1000*ms);
+}
+
+
+void delayMicroseconds(unsigned int us)
+{
+  hostElapse(us);
+}
+
+
+size_t HardwareSerial::write(uint8_t value)
+{
+  putchar(value);
+  return 1;
+}
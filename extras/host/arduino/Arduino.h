@@ -0,0 +1,191 @@
+/*
+ * Host build of the Multipurpose Shield library.
+ *
+ * Just enough of the Arduino core to run the drivers on a PC against
+ * simulated peripherals. The board is an Uno: the pins live in the
+ * port registers of an ATmega328, and time is simulated. It only
+ * advances in delay(), delayMicroseconds() and the core functions, which
+ * take about as long as they do on a 16 MHz AVR.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define __AVR_ATmega328P__
+#define F_CPU 16000000UL
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define SDA 18
+#define SCL 19
+
+#define PI 3.1415926535897932384626433832795
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+#define _BV(bit) (1 << (bit))
+
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(const uint16_t *)(address))
+
+
+// Core functions taking longer than a few cycles, in microseconds.
+#define HOST_PIN_US  4 /* pinMode(), digitalWrite(), digitalRead() */
+#define HOST_CLOCK_US  1 /* millis(), micros() */
+
+
+void hostSync(void);
+
+// An I/O register. The simulated peripherals see every write through
+// the operators right away, writes through a pointer or a reference at
+// the next core function call.
+class HostRegister
+{
+public:
+  HostRegister(uint8_t value=0) : _value(value) {}
+  operator volatile uint8_t&(void) { return _value; }
+  HostRegister& operator=(int value) { _value = value; hostSync(); return *this; }
+  HostRegister& operator|=(int value) { _value |= value; hostSync(); return *this; }
+  HostRegister& operator&=(int value) { _value &= value; hostSync(); return *this; }
+  HostRegister& operator^=(int value) { _value ^= value; hostSync(); return *this; }
+
+  volatile uint8_t _value;
+};
+
+extern HostRegister DDRB, PORTB, PINB;
+extern HostRegister DDRC, PORTC, PINC;
+extern HostRegister DDRD, PORTD, PIND;
+extern HostRegister SREG;
+extern HostRegister TWCR, TWSR, TWDR, TWBR, TWAR;
+
+// Macros like in <avr/io.h>, for #ifdef PORTB.
+#define PORTB PORTB
+#define PORTC PORTC
+#define PORTD PORTD
+
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+#define TWPS0 0
+#define TWPS1 1
+
+// The I bit of SREG, devices only raise interrupts while it is set.
+#define SREG_I 0x80
+
+#define ISR(vector) extern "C" void vector(void)
+#define cli() (SREG &= ~SREG_I)
+#define sei() (SREG |= SREG_I)
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+#define NOT_A_PORT 0
+#define PB 2
+#define PC 3
+#define PD 4
+
+#define digitalPinToPort(pin) ((pin)<8? PD : (pin)<14? PB : (pin)<20? PC : NOT_A_PORT)
+#define digitalPinToBitMask(pin) ((uint8_t)_BV((pin)<8? (pin) : (pin)<14? (pin)-8 : (pin)-14))
+volatile uint8_t *portOutputRegister(uint8_t port);
+volatile uint8_t *portInputRegister(uint8_t port);
+volatile uint8_t *portModeRegister(uint8_t port);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+void noTone(uint8_t pin);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+
+// A simulated peripheral, sync() is called with the current time
+// whenever the pins or the time may have changed. It reads the pins with
+// hostPinDriven() and answers with hostPinInput().
+class HostDevice
+{
+public:
+  HostDevice(void);
+  virtual ~HostDevice(void);
+  virtual void sync(unsigned long now) = 0;
+
+private:
+  HostDevice *_next;
+  friend void hostSync(void);
+};
+
+// Level the Arduino drives on a pin, -1 if the pin is an input.
+int8_t hostPinDriven(uint8_t pin);
+// Level the Arduino reads on an input pin, inputs read 1 (pull-up)
+// unless a device drives them.
+void hostPinInput(uint8_t pin, uint8_t level);
+
+// Runs an interrupt handler from sync(), the registers it writes are
+// synced again right away.
+void hostInterrupt(void (*vector)(void));
+
+// Simulated time, without the cost of calling micros().
+unsigned long hostMicros(void);
+void hostElapse(unsigned long us);
+
+
+#include "Print.h"
+
+class HardwareSerial : public Print
+{
+public:
+  void begin(unsigned long baud) {}
+  virtual size_t write(uint8_t value);
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+
+#endif /* Arduino_h */
@@ -0,0 +1,73 @@
+/*
+ * Host build of the Multipurpose Shield library, Print class of the
+ * Arduino core.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "Print.h"
+
+
+size_t Print::write(const char *str)
+{
+  if (str==0) return 0;
+  return write((const uint8_t *)str,strlen(str));
+}
+
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+
+size_t Print::print(long n, int base)
+{
+  if (n<0 && base==DEC) return print('-') + print((unsigned long)-n,base);
+  return print((unsigned long)n,base);
+}
+
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[8*sizeof(long) + 1];
+  char *str = &buf[sizeof(buf) - 1];
+  if (base<2) base = 10;
+  *str = '\0';
+  do
+  {
+    char c = n%base;
+    n /= base;
+    *--str = c<10? c + '0' : c + 'A' - 10;
+  }
+  while (n!=0);
+  return write(str);
+}
+
+
+size_t Print::print(double n, int digits)
+{
+  char buf[32];
+  snprintf(buf,sizeof(buf),"%.*f",digits,n);
+  return write(buf);
+}
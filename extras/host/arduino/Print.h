@@ -0,0 +1,54 @@
+/*
+ * Host build of the Multipurpose Shield library, Print class of the
+ * Arduino core.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef Print_h
+#define Print_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+class Print
+{
+public:
+  virtual size_t write(uint8_t) = 0;
+  size_t write(const char *str);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  virtual void flush(void) {}
+
+  size_t print(const char *str) { return write(str); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n,base); }
+  size_t print(int n, int base = DEC) { return print((long)n,base); }
+  size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n,base); }
+  size_t print(long n, int base = DEC);
+  size_t print(unsigned long n, int base = DEC);
+  size_t print(double n, int digits = 2);
+
+  size_t println(void) { return write("\r\n"); }
+  template <class T> size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <class T> size_t println(T value, int format) { size_t n = print(value,format); return n + println(); }
+};
+
+#endif /* Print_h */
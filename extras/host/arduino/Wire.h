@@ -0,0 +1,44 @@
+/*
+ * Host build of the Multipurpose Shield library, declarations of the
+ * Wire library. There is no simulated TWI peripheral, this only lets the
+ * drivers compile.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+class TwoWire
+{
+public:
+  void begin(void);
+  void begin(uint8_t address);
+  void end(void);
+  void setClock(uint32_t clock);
+  void beginTransmission(uint8_t address);
+  uint8_t endTransmission(uint8_t stop = true);
+  uint8_t requestFrom(uint8_t address, uint8_t quantity, uint8_t stop = true);
+  size_t write(uint8_t value);
+  int available(void);
+  int read(void);
+};
+
+extern TwoWire Wire;
+
+#endif /* TwoWire_h */
@@ -0,0 +1,72 @@
+/*
+ * Checks for the host tests.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <stdio.h>
+
+
+static int failures = 0;
+
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      printf("%s:%d: failed: %s\n",__FILE__,__LINE__,#condition); \
+      failures++; \
+    } \
+  } \
+  while (0)
+
+#define CHECK_EQUAL(expected,actual) \
+  do \
+  { \
+    long e = (long)(expected); \
+    long a = (long)(actual); \
+    if (e!=a) \
+    { \
+      printf("%s:%d: %s is %ld, expected %ld\n",__FILE__,__LINE__,#actual,a,e); \
+      failures++; \
+    } \
+  } \
+  while (0)
+
+#define CHECK_STRING(expected,actual) \
+  do \
+  { \
+    if (strcmp((expected),(actual))!=0) \
+    { \
+      printf("%s:%d: %s is \"%s\", expected \"%s\"\n",__FILE__,__LINE__,#actual,(actual),(expected)); \
+      failures++; \
+    } \
+  } \
+  while (0)
+
+
+// Exit code of the test.
+static int report(void)
+{
+  if (failures==0) printf("ok\n");
+  return failures!=0;
+}
+
+
+#endif /* __CHECK_H__ */
@@ -0,0 +1,234 @@
+/*
+ * Simulated DS18B20 chips on a 1-Wire bus for the host build.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "ds18b20.h"
+
+
+// Power-on scratchpad: 85 degrees, alarms, 12 bits.
+static const uint8_t scratchpadDefault[8] = { 0x50, 0x05, 0x4b, 0x46, 0x7f, 0xff, 0x0c, 0x10 };
+
+
+DS18B20Bus::DS18B20Bus(volatile uint8_t& ddr, volatile uint8_t& port, volatile uint8_t& pin, uint8_t bit) :
+  _ddr(ddr),
+  _port(port),
+  _pin(pin),
+  _mask(_BV(bit)),
+  _count(0),
+  _masterLow(0),
+  _fall(0),
+  _lowUntil(0),
+  _presenceFrom(0),
+  _presenceUntil(0)
+{
+  resetStatistics();
+}
+
+
+uint8_t DS18B20Bus::add(const uint8_t *rom, int16_t temperature)
+{
+  Chip& chip = _chips[_count];
+  memcpy(chip.rom,rom,7);
+  chip.rom[7] = crc(chip.rom,7);
+  memcpy(chip.scratchpad,scratchpadDefault,8);
+  chip.scratchpad[8] = crc(chip.scratchpad,8);
+  chip.temperature = temperature;
+  chip.state = idle;
+  chip.ready = 0;
+  return _count++;
+}
+
+
+void DS18B20Bus::sync(unsigned long now)
+{
+  uint8_t masterLow = (_ddr&_mask)!=0 && (_port&_mask)==0;
+  if (masterLow!=_masterLow)
+  {
+    _masterLow = masterLow;
+    if (masterLow!=0) falling(now);
+    else rising(now);
+  }
+  uint8_t low = masterLow!=0 || now<_lowUntil || (now>=_presenceFrom && now<_presenceUntil);
+  if (low!=0) _pin &= ~_mask;
+  else _pin |= _mask;
+}
+
+
+// Every chip sending a 0 in this slot pulls the bus low.
+void DS18B20Bus::falling(unsigned long now)
+{
+  _fall = now;
+  for (uint8_t i=0; i<_count; i++)
+  {
+    if (sending(_chips[i],now)==0) _lowUntil = now + DS18B20_READ_US;
+  }
+}
+
+
+void DS18B20Bus::rising(unsigned long now)
+{
+  unsigned long length = now - _fall;
+  if (length>=DS18B20_RESET_US)
+  {
+    _statistics.resets++;
+    for (uint8_t i=0; i<_count; i++)
+    {
+      _chips[i].state = romCommand;
+      _chips[i].count = 0;
+    }
+    if (_count>0)
+    {
+      _presenceFrom = now + DS18B20_PRESENCE_WAIT_US;
+      _presenceUntil = _presenceFrom + DS18B20_PRESENCE_US;
+    }
+    return;
+  }
+
+  uint8_t value = length<30;
+  if (length>DS18B20_WRITE1_US && (length<DS18B20_WRITE0_US || length>DS18B20_SLOT_US))
+  {
+    _statistics.timingErrors++;
+  }
+  _statistics.slots++;
+  for (uint8_t i=0; i<_count; i++)
+  {
+    step(_chips[i],value,now);
+  }
+}
+
+
+// Bit the chip sends in the next slot, -1 if it is listening.
+int8_t DS18B20Bus::sending(Chip& chip, unsigned long now)
+{
+  switch (chip.state)
+  {
+    case search:
+      if (chip.count%3==2) return -1;
+      return bit(chip.rom,chip.count/3) ^ (chip.count%3);
+    case convert:
+      return now>=chip.ready;
+    case readScratchpad:
+      return chip.count<72? bit(chip.scratchpad,chip.count) : 1;
+    default:
+      return -1;
+  }
+}
+
+
+// One slot, value is the bit the master wrote.
+void DS18B20Bus::step(Chip& chip, uint8_t value, unsigned long now)
+{
+  switch (chip.state)
+  {
+    case romCommand:
+    case functionCommand:
+      chip.shift = (chip.shift>>1) | (value<<7);
+      if (++chip.count==8) command(chip,now);
+      break;
+
+    case search:
+      // Bit, complement, then the direction the master takes.
+      if (chip.count%3==2 && value!=bit(chip.rom,chip.count/3)) chip.state = idle;
+      else if (++chip.count==3*64) chip.state = idle;
+      break;
+
+    case matchRom:
+      if (value!=bit(chip.rom,chip.count)) chip.state = idle;
+      else if (++chip.count==64)
+      {
+        chip.state = functionCommand;
+        chip.count = 0;
+      }
+      break;
+
+    case readScratchpad:
+      if (chip.count<72) chip.count++;
+      break;
+
+    case writeScratchpad:
+      // TH, TL and the configuration register.
+      if (value!=0) chip.scratchpad[2+chip.count/8] |= _BV(chip.count%8);
+      else chip.scratchpad[2+chip.count/8] &= ~_BV(chip.count%8);
+      if (++chip.count==24)
+      {
+        chip.scratchpad[4] |= 0x1f;
+        chip.scratchpad[8] = crc(chip.scratchpad,8);
+        chip.state = idle;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+
+void DS18B20Bus::command(Chip& chip, unsigned long now)
+{
+  uint8_t resolution = 9 + ((chip.scratchpad[4]>>5)&0x03);
+  uint16_t undefined = (1<<(12-resolution)) - 1;
+  chip.count = 0;
+  if (chip.state==romCommand)
+  {
+    if (chip.shift==0xf0) chip.state = search;
+    else if (chip.shift==0x55) chip.state = matchRom;
+    else if (chip.shift==0xcc) chip.state = functionCommand;
+    else chip.state = idle;
+    return;
+  }
+  switch (chip.shift)
+  {
+    case 0x44:
+      // The undefined low bits read 1 to catch drivers using them.
+      chip.scratchpad[0] = chip.temperature | undefined;
+      chip.scratchpad[1] = (chip.temperature | undefined) >> 8;
+      chip.scratchpad[8] = crc(chip.scratchpad,8);
+      chip.ready = now + (750000UL>>(12-resolution));
+      chip.state = convert;
+      break;
+    case 0xbe:
+      chip.state = readScratchpad;
+      break;
+    case 0x4e:
+      chip.state = writeScratchpad;
+      break;
+    default:
+      // Copy Scratchpad, EEPROM is not simulated.
+      chip.state = idle;
+      break;
+  }
+}
+
+
+// Dallas CRC, x^8 + x^5 + x^4 + 1 LSB first.
+uint8_t DS18B20Bus::crc(const uint8_t *bytes, uint8_t size)
+{
+  uint8_t result = 0;
+  for (uint8_t i=0; i<size; i++)
+  {
+    uint8_t value = bytes[i];
+    for (uint8_t j=0; j<8; j++)
+    {
+      uint8_t mix = (result^value)&0x01;
+      result >>= 1;
+      if (mix!=0) result ^= 0x8c;
+      value >>= 1;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,117 @@
+/*
+ * Simulated DS18B20 chips on a 1-Wire bus for the host build: reset and
+ * presence, time slots, ROM search, Match ROM and Skip ROM, conversion
+ * and the scratchpad.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __DS18B20_H__
+#define __DS18B20_H__
+
+#include "Arduino.h"
+
+
+#define DS18B20_MAX_CHIPS  8
+
+// Limits of the datasheet, the chips take the worst case.
+#define DS18B20_RESET_US  480 /* minimum reset pulse */
+#define DS18B20_PRESENCE_WAIT_US  60 /* presence pulse starts at most... */
+#define DS18B20_PRESENCE_US  60 /* ...and lasts at least */
+#define DS18B20_WRITE1_US  15 /* a 1 is released before... */
+#define DS18B20_WRITE0_US  60 /* ...a 0 is held at least */
+#define DS18B20_SLOT_US  120
+#define DS18B20_READ_US  15 /* a 0 is valid until */
+
+
+struct DS18B20Statistics
+{
+  uint16_t resets;
+  uint32_t slots;
+  uint16_t timingErrors; // pulses of none of the lengths above
+};
+
+
+// The chips watch one port bit through its registers, a mock port works
+// as well as a real one. Every master pulse is measured from its falling
+// to its rising edge. Code between writes takes no simulated time, so
+// the recovery time between slots is not checked.
+class DS18B20Bus : public HostDevice
+{
+public:
+  DS18B20Bus(volatile uint8_t& ddr, volatile uint8_t& port, volatile uint8_t& pin, uint8_t bit);
+
+  virtual void sync(unsigned long now);
+
+  // Adds a chip, the last ROM byte is replaced by the CRC. Temperatures
+  // are in 1/16 degrees, they are sampled when a conversion starts.
+  uint8_t add(const uint8_t *rom, int16_t temperature);
+  void setTemperature(uint8_t chip, int16_t temperature) { _chips[chip].temperature = temperature; }
+  const uint8_t *rom(uint8_t chip) { return _chips[chip].rom; }
+  uint8_t chips(void) { return _count; }
+  uint8_t resolution(uint8_t chip) { return 9 + ((_chips[chip].scratchpad[4]>>5)&0x03); }
+
+  const DS18B20Statistics& statistics(void) { return _statistics; }
+  void resetStatistics(void) { memset(&_statistics,0,sizeof(_statistics)); }
+
+private:
+  enum State
+  {
+    idle,
+    romCommand,
+    search,
+    matchRom,
+    functionCommand,
+    convert,
+    readScratchpad,
+    writeScratchpad,
+  };
+
+  struct Chip
+  {
+    uint8_t rom[8];
+    uint8_t scratchpad[9];
+    int16_t temperature;
+    State state;
+    uint8_t shift;
+    uint8_t count; // bits done in this state
+    unsigned long ready; // end of the conversion
+  };
+
+  volatile uint8_t& _ddr;
+  volatile uint8_t& _port;
+  volatile uint8_t& _pin;
+  uint8_t _mask;
+  Chip _chips[DS18B20_MAX_CHIPS];
+  uint8_t _count;
+  uint8_t _masterLow;
+  unsigned long _fall;
+  unsigned long _lowUntil; // a chip sends a 0
+  unsigned long _presenceFrom;
+  unsigned long _presenceUntil;
+  DS18B20Statistics _statistics;
+
+  void falling(unsigned long now);
+  void rising(unsigned long now);
+  int8_t sending(Chip& chip, unsigned long now);
+  void step(Chip& chip, uint8_t value, unsigned long now);
+  void command(Chip& chip, unsigned long now);
+  static uint8_t bit(const uint8_t *bytes, uint8_t index) { return (bytes[index>>3]>>(index&0x07))&0x01; }
+  static uint8_t crc(const uint8_t *bytes, uint8_t size);
+};
+
+
+#endif /* __DS18B20_H__ */
@@ -0,0 +1,306 @@
+/*
+ * Simulated HD44780 LCD controller for the host build.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "hd44780.h"
+
+
+HD44780::HD44780(uint8_t rs, uint8_t rw, uint8_t enable,
+                 uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+{
+  _dataPins[0] = d4;
+  _dataPins[1] = d5;
+  _dataPins[2] = d6;
+  _dataPins[3] = d7;
+  _wires = 4;
+  init(rs,rw,enable);
+}
+
+
+HD44780::HD44780(uint8_t rs, uint8_t rw, uint8_t enable,
+                 uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+                 uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+{
+  _dataPins[0] = d0;
+  _dataPins[1] = d1;
+  _dataPins[2] = d2;
+  _dataPins[3] = d3;
+  _dataPins[4] = d4;
+  _dataPins[5] = d5;
+  _dataPins[6] = d6;
+  _dataPins[7] = d7;
+  _wires = 8;
+  init(rs,rw,enable);
+}
+
+
+// Power-on state: display cleared and off, 8-bit interface, one line,
+// increment without shift.
+void HD44780::init(uint8_t rs, uint8_t rw, uint8_t enable)
+{
+  _rs = rs;
+  _rw = rw;
+  _enable = enable;
+  memset(_ddram,' ',sizeof(_ddram));
+  memset(_cgram,0,sizeof(_cgram));
+  _address = 0;
+  _cgramSelected = false;
+  _entryMode = 0x02;
+  _displayControl = 0;
+  _functionSet = 0x10;
+  _shift = 0;
+  _enableLevel = 0;
+  _reading = 0;
+  _output = 0;
+  _nibble = 0;
+  _byte = 0;
+  _drop = false;
+  _busyUntil = 0;
+  _commandUs = HD44780_COMMAND_US;
+  _clearUs = HD44780_CLEAR_US;
+  resetStatistics();
+}
+
+
+void HD44780::setTiming(uint16_t command, uint16_t clear)
+{
+  _commandUs = command;
+  _clearUs = clear;
+}
+
+
+void HD44780::resetStatistics(void)
+{
+  memset(&_statistics,0,sizeof(_statistics));
+}
+
+
+void HD44780::sync(unsigned long now)
+{
+  uint8_t enable = hostPinDriven(_enable)==1;
+  if (enable!=_enableLevel)
+  {
+    _enableLevel = enable;
+    if (enable!=0)
+    {
+      _statistics.pulses++;
+      if (_rw!=255 && hostPinDriven(_rw)==1)
+      {
+        if (_nibble==0) read();
+        _reading = 1;
+      }
+    }
+    else if (_reading!=0)
+    {
+      _reading = 0;
+      if (_wires==4 && (_functionSet&0x10)==0) _nibble = !_nibble;
+    }
+    else latch(now);
+  }
+  if (_reading!=0)
+  {
+    // D4 to D7 carry the high nibble first.
+    if (_wires==8 || (_functionSet&0x10)!=0) driveBus(_wires==8? _output : _output>>4);
+    else driveBus(_nibble==0? _output>>4 : _output);
+  }
+}
+
+
+// Busy flag and address counter, or the RAM contents at the address.
+void HD44780::read(void)
+{
+  _statistics.reads++;
+  if (hostPinDriven(_rs)==1)
+  {
+    _output = _cgramSelected==true? _cgram[_address&0x3f] : _ddram[_address&0x7f];
+    moveAddress((_entryMode&0x02)!=0);
+  }
+  else _output = (hostMicros()<_busyUntil? 0x80 : 0) | (_address&0x7f);
+}
+
+
+// Unconnected or undriven pins read 0.
+uint8_t HD44780::readBus(void)
+{
+  uint8_t value = 0;
+  for (uint8_t i=0; i<_wires; i++)
+  {
+    if (hostPinDriven(_dataPins[i])==1) value |= 1<<i;
+  }
+  return value;
+}
+
+
+void HD44780::driveBus(uint8_t value)
+{
+  for (uint8_t i=0; i<_wires; i++)
+  {
+    hostPinInput(_dataPins[i],(value>>i)&0x01);
+  }
+}
+
+
+void HD44780::latch(unsigned long now)
+{
+  uint8_t rs = hostPinDriven(_rs)==1;
+  uint8_t value = readBus();
+  if ((_functionSet&0x10)!=0)
+  {
+    // 8-bit interface, with 4 wires the low nibble reads 0.
+    if (_wires==4) value <<= 4;
+    if (now<_busyUntil) _statistics.dropped++;
+    else execute(value,rs,now);
+  }
+  else if (_nibble==0)
+  {
+    _byte = value<<4;
+    _drop = now<_busyUntil;
+    _nibble = 1;
+  }
+  else
+  {
+    _nibble = 0;
+    if (_drop==true) _statistics.dropped++;
+    else execute(_byte|(value&0x0f),rs,now);
+  }
+}
+
+
+void HD44780::execute(uint8_t value, uint8_t rs, unsigned long now)
+{
+  uint16_t duration = _commandUs;
+  if (rs!=0)
+  {
+    _statistics.data++;
+    writeData(value);
+  }
+  else
+  {
+    _statistics.commands++;
+    if (value==0x01 || (value&0xfe)==0x02) duration = _clearUs;
+    instruction(value);
+  }
+  _busyUntil = now + duration;
+  _statistics.execUs += duration;
+}
+
+
+void HD44780::instruction(uint8_t value)
+{
+  if ((value&0x80)!=0)
+  {
+    _address = value&0x7f;
+    _cgramSelected = false;
+  }
+  else if ((value&0x40)!=0)
+  {
+    _address = value&0x3f;
+    _cgramSelected = true;
+  }
+  else if ((value&0x20)!=0)
+  {
+    _functionSet = value&0x1c;
+    _nibble = 0;
+  }
+  else if ((value&0x10)!=0)
+  {
+    uint8_t length = (_functionSet&0x08)!=0? 40 : 80;
+    if ((value&0x08)==0) moveAddress((value&0x04)!=0);
+    else if ((value&0x04)!=0) _shift = (_shift + length - 1)%length;
+    else _shift = (_shift + 1)%length;
+  }
+  else if ((value&0x08)!=0) _displayControl = value&0x07;
+  else if ((value&0x04)!=0) _entryMode = value&0x03;
+  else if (value!=0)
+  {
+    if (value==0x01)
+    {
+      memset(_ddram,' ',sizeof(_ddram));
+      _entryMode |= 0x02;
+    }
+    _address = 0;
+    _cgramSelected = false;
+    _shift = 0;
+  }
+}
+
+
+void HD44780::writeData(uint8_t value)
+{
+  boolean increment = (_entryMode&0x02)!=0;
+  if (_cgramSelected==true)
+  {
+    _cgram[_address&0x3f] = value;
+    moveAddress(increment);
+    return;
+  }
+  _ddram[_address&0x7f] = value;
+  moveAddress(increment);
+  if ((_entryMode&0x01)!=0)
+  {
+    // Shift the display along with the cursor.
+    uint8_t length = (_functionSet&0x08)!=0? 40 : 80;
+    _shift = (_shift + (increment==true? 1 : length - 1))%length;
+  }
+}
+
+
+// DDRAM runs from 0x00 to 0x4f on one line, from 0x00 to 0x27 and from
+// 0x40 to 0x67 on two lines.
+void HD44780::moveAddress(boolean increment)
+{
+  if (_cgramSelected==true)
+  {
+    _address = (_address + (increment==true? 1 : 0x3f))&0x3f;
+  }
+  else if ((_functionSet&0x08)==0)
+  {
+    if (increment==true) _address = _address==0x4f? 0 : _address + 1;
+    else _address = _address==0? 0x4f : _address - 1;
+  }
+  else if (increment==true)
+  {
+    if (_address==0x27) _address = 0x40;
+    else if (_address==0x67) _address = 0;
+    else _address++;
+  }
+  else
+  {
+    if (_address==0) _address = 0x67;
+    else if (_address==0x40) _address = 0x27;
+    else _address--;
+  }
+}
+
+
+uint8_t HD44780::at(uint8_t col, uint8_t row)
+{
+  if ((_functionSet&0x08)==0) return _ddram[(col + _shift)%80];
+  return _ddram[(row&0x01)*0x40 + (col + _shift)%40];
+}
+
+
+const char *HD44780::row(uint8_t row, char *buffer, uint8_t cols)
+{
+  for (uint8_t i=0; i<cols; i++)
+  {
+    buffer[i] = at(i,row);
+  }
+  buffer[cols] = '\0';
+  return buffer;
+}
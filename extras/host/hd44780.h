@@ -0,0 +1,118 @@
+/*
+ * Simulated HD44780 LCD controller for the host build.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __HD44780_H__
+#define __HD44780_H__
+
+#include "Arduino.h"
+
+
+// Execution times at fosc = 270 kHz.
+#define HD44780_COMMAND_US  37
+#define HD44780_CLEAR_US  1520
+
+
+struct HD44780Statistics
+{
+  uint32_t commands; // instructions executed
+  uint32_t data; // data register writes executed
+  uint32_t pulses; // enable pulses, reads included
+  uint32_t reads; // busy flag and address reads
+  uint32_t execUs; // time the controller was busy executing
+  uint32_t dropped; // bytes written while the controller was busy
+};
+
+
+// The controller latches on the falling edge of E and puts the busy flag
+// and address counter on the data pins while E is high with RW high.
+// It powers up with an 8-bit interface, in 4-bit mode only D4 to D7 are
+// connected. Writing while the controller is busy loses the byte.
+class HD44780 : public HostDevice
+{
+public:
+  // 4-bit interface, rw is 255 when RW is tied low.
+  HD44780(uint8_t rs, uint8_t rw, uint8_t enable,
+          uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
+  // 8-bit interface.
+  HD44780(uint8_t rs, uint8_t rw, uint8_t enable,
+          uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
+          uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
+
+  virtual void sync(unsigned long now);
+
+  // Execution times, e.g. for a controller with a faster oscillator.
+  void setTiming(uint16_t command, uint16_t clear);
+
+  // What the display shows at a position, display shift included.
+  uint8_t at(uint8_t col, uint8_t row);
+  // A row as a string of cols characters, buffer holds cols+1 bytes.
+  const char *row(uint8_t row, char *buffer, uint8_t cols);
+
+  uint8_t ddram(uint8_t address) { return _ddram[address&0x7f]; }
+  uint8_t cgram(uint8_t address) { return _cgram[address&0x3f]; }
+  uint8_t address(void) { return _address; }
+  uint8_t entryMode(void) { return _entryMode; }
+  uint8_t displayControl(void) { return _displayControl; }
+  uint8_t functionSet(void) { return _functionSet; }
+  uint8_t shift(void) { return _shift; }
+  boolean busy(void) { return hostMicros()<_busyUntil; }
+
+  const HD44780Statistics& statistics(void) { return _statistics; }
+  void resetStatistics(void);
+
+private:
+  uint8_t _rs;
+  uint8_t _rw;
+  uint8_t _enable;
+  uint8_t _dataPins[8];
+  uint8_t _wires; // 4 or 8 data pins connected
+
+  uint8_t _ddram[0x80];
+  uint8_t _cgram[0x40];
+  uint8_t _address; // address counter
+  boolean _cgramSelected;
+  uint8_t _entryMode;
+  uint8_t _displayControl;
+  uint8_t _functionSet;
+  uint8_t _shift; // display shift
+
+  uint8_t _enableLevel;
+  uint8_t _reading; // driving the data pins
+  uint8_t _output; // byte being read
+  uint8_t _nibble; // the high nibble of the byte was transferred
+  uint8_t _byte; // high nibble received
+  boolean _drop; // the high nibble came while busy
+  unsigned long _busyUntil;
+  uint16_t _commandUs;
+  uint16_t _clearUs;
+  HD44780Statistics _statistics;
+
+  void init(uint8_t rs, uint8_t rw, uint8_t enable);
+  uint8_t readBus(void);
+  void driveBus(uint8_t value);
+  void latch(unsigned long now);
+  void execute(uint8_t value, uint8_t rs, unsigned long now);
+  void read(void);
+  void instruction(uint8_t value);
+  void writeData(uint8_t value);
+  void moveAddress(boolean increment);
+};
+
+
+#endif /* __HD44780_H__ */
@@ -0,0 +1,179 @@
+/*
+ * LCD benchmark for the host build.
+ *
+ * Replays the dashboard of the WeatherStation example on a simulated
+ * HD44780 with the different LiquidCrystal modes, and reports per frame
+ * the bytes and enable pulses sent, the time the controller spends
+ * executing them and the time the sketch spends in the LCD functions.
+ * Fails if the display does not show the expected text or if the
+ * controller lost a byte.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include "Arduino.h"
+#include "LiquidCrystal.h"
+#include "LiquidCrystalFast.h"
+#include "hd44780.h"
+
+
+#define FRAMES  100
+
+// Shield pinout, RW is not connected on the shield.
+#define PIN_RS  6
+#define PIN_RW  8
+#define PIN_E  7
+#define PIN_D4  5
+#define PIN_D5  4
+#define PIN_D6  3
+#define PIN_D7  2
+
+#define HEADER  " t  rh  mbar lum"
+
+enum
+{
+  modeDirect = 0x01, // setCursor and print every field
+  modeShadow = 0x02, // shadow buffer, flush every frame
+  modeBusyFlag = 0x04, // RW connected, poll the busy flag
+  modeAsync = 0x08, // queue, drained with service()
+};
+
+
+static uint8_t failures = 0;
+
+
+// Sensor values changing at different rates, like in the weather
+// station where mostly the light level changes.
+static void values(uint16_t frame, int& t, int& rh, int& p, int& light)
+{
+  t = 21 + (frame/40)%2;
+  rh = 45 + (frame/25)%3;
+  p = 1013 - (frame/50);
+  light = 40 + (7*frame)%20;
+}
+
+
+static void drawFrame(LiquidCrystal& lcd, uint16_t frame)
+{
+  int t, rh, p, light;
+  values(frame,t,rh,p,light);
+  lcd.setCursor(0,1);
+  lcd.printField(t,2);
+  lcd.write(0xdf);
+  lcd.print(' ');
+  lcd.printField(rh,2,"%");
+  lcd.print(' ');
+  lcd.printField(p,4);
+  lcd.print(' ');
+  lcd.printField(light,2,"%");
+  lcd.flush();
+}
+
+
+static void check(HD44780& sim, uint16_t frame, const char *name)
+{
+  char expected[17];
+  char shown[17];
+  int t, rh, p, light;
+  values(frame,t,rh,p,light);
+  snprintf(expected,sizeof(expected),"%2d\xdf %2d%% %4d %2d%%",t,rh,p,light);
+  if (strcmp(sim.row(0,shown,16),HEADER)!=0 || strcmp(sim.row(1,shown,16),expected)!=0)
+  {
+    printf("%s, frame %u: shows \"%s\", expected \"%s\"\n",name,frame,shown,expected);
+    failures++;
+  }
+}
+
+
+static void benchmark(LiquidCrystal& lcd, HD44780& sim, uint8_t mode, const char *name)
+{
+  lcd.begin(16,2);
+  lcd.print(HEADER);
+  if ((mode&modeBusyFlag)!=0) lcd.busyFlag();
+  if ((mode&modeShadow)!=0) lcd.shadowBuffer();
+  if ((mode&modeAsync)!=0) lcd.asyncQueue();
+  drawFrame(lcd,0);
+  lcd.noAsyncQueue();
+  if ((mode&modeAsync)!=0) lcd.asyncQueue();
+  sim.resetStatistics();
+  lcd.resetStatistics();
+
+  unsigned long drawing = 0;
+  unsigned long total = 0;
+  for (uint16_t frame=1; frame<=FRAMES; frame++)
+  {
+    unsigned long start = hostMicros();
+    drawFrame(lcd,frame);
+    drawing += hostMicros() - start;
+    if ((mode&modeAsync)!=0)
+    {
+      // Meanwhile the sketch could do something else.
+      lcd.noAsyncQueue();
+      lcd.asyncQueue();
+    }
+    total += hostMicros() - start;
+    check(sim,frame,name);
+  }
+  lcd.noAsyncQueue();
+
+  const HD44780Statistics& s = sim.statistics();
+  const LcdStatistics& l = lcd.statistics();
+  if (s.dropped!=0)
+  {
+    printf("%s: the controller lost %u bytes\n",name,s.dropped);
+    failures++;
+  }
+  if (l.commands!=s.commands || l.data!=s.data || l.pulses!=s.pulses-2*s.reads)
+  {
+    printf("%s: LcdStatistics counted %u+%u bytes and %u pulses, the controller %u+%u and %u\n",
+           name,l.commands,l.data,l.pulses,s.commands,s.data,s.pulses-2*s.reads);
+    failures++;
+  }
+  printf("%-34s %6.1f %7.1f %8.1f %8.1f %8.1f\n",name,
+         (float)(s.commands+s.data)/FRAMES,(float)s.pulses/FRAMES,
+         (float)s.execUs/FRAMES,(float)drawing/FRAMES,(float)total/FRAMES);
+}
+
+
+int main(void)
+{
+  printf("WeatherStation dashboard on a 16x2 HD44780, 4-bit, %u frames\n",FRAMES);
+  printf("%-34s %6s %7s %8s %8s %8s\n","per frame","bytes","pulses","exec us","draw us","total us");
+  {
+    HD44780 sim(PIN_RS,255,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7);
+    LiquidCrystal lcd(PIN_RS,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7);
+    benchmark(lcd,sim,modeDirect,"LiquidCrystal");
+    benchmark(lcd,sim,modeShadow,"LiquidCrystal, shadow");
+  }
+  {
+    HD44780 sim(PIN_RS,PIN_RW,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7);
+    LiquidCrystal lcd(PIN_RS,PIN_RW,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7);
+    benchmark(lcd,sim,modeDirect|modeBusyFlag,"LiquidCrystal, busy flag");
+    benchmark(lcd,sim,modeShadow|modeBusyFlag,"LiquidCrystal, shadow, busy flag");
+  }
+  {
+    HD44780 sim(PIN_RS,255,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7);
+    LiquidCrystalFast<PIN_RS,PIN_E,PIN_D4,PIN_D5,PIN_D6,PIN_D7> lcd;
+    lcd.init();
+    benchmark(lcd,sim,modeDirect,"LiquidCrystalFast");
+    benchmark(lcd,sim,modeShadow,"LiquidCrystalFast, shadow");
+    benchmark(lcd,sim,modeShadow|modeAsync,"LiquidCrystalFast, shadow, queue");
+  }
+  printf("draw: time spent in the LCD functions, total: until the display\n"
+         "is up to date, with %u us per digitalWrite() like on a 16 MHz AVR.\n",HOST_PIN_US);
+  return failures!=0;
+}
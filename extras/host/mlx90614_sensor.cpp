@@ -0,0 +1,216 @@
+/*
+ * Simulated MLX90614 infrared thermometer for the host build.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "mlx90614_sensor.h"
+
+
+extern "C" void TWI_vect(void);
+
+
+MLX90614Sensor::MLX90614Sensor(uint8_t address) :
+  _address(address),
+  _corrupt(0),
+  _phase(released),
+  _interrupt(false),
+  _handling(false),
+  _executed(0),
+  _index(0)
+{
+  memset(_memory,0,sizeof(_memory));
+  resetStatistics();
+}
+
+
+void MLX90614Sensor::sync(unsigned long now)
+{
+  if ((TWCR&_BV(TWINT))!=0) execute();
+  // The syncs caused by the handler execute its TWCR writes, the
+  // interrupts they raise are handled here once it returns.
+  while (_interrupt==true && _handling==false && (TWCR&_BV(TWIE))!=0 && (SREG&SREG_I)!=0)
+  {
+    uint16_t executed = _executed;
+    _handling = true;
+    hostInterrupt(TWI_vect);
+    _handling = false;
+    // A handler leaving the flag set would run again forever.
+    if (_executed==executed) break;
+  }
+}
+
+
+// Writing TWINT clears the flag and starts the action TWCR selects.
+void MLX90614Sensor::execute(void)
+{
+  uint8_t control = TWCR;
+  TWCR._value &= ~_BV(TWINT);
+  _interrupt = false;
+  _executed++;
+  if ((control&_BV(TWEN))==0) return;
+
+  if ((control&_BV(TWSTO))!=0)
+  {
+    if (_phase!=released) stop();
+    TWCR._value &= ~_BV(TWSTO);
+    if ((control&_BV(TWSTA))==0) return;
+  }
+  if ((control&_BV(TWSTA))!=0)
+  {
+    uint8_t status = _phase==released? 0x08 : 0x10;
+    start();
+    raise(status);
+    return;
+  }
+
+  switch (_phase)
+  {
+    case addressing:
+    {
+      uint8_t value = TWDR;
+      boolean read = (value&0x01)!=0;
+      // A read needs the command of the write before the repeated start.
+      boolean ack = (value>>1)==_address && (read==false || _index==2);
+      if (ack==true)
+      {
+        if (read==false) _index = 0;
+        _frame[_index++] = value;
+        _phase = read==true? receiving : transmitting;
+      }
+      else _phase = refused;
+      if (read==true) raise(ack==true? 0x40 : 0x48);
+      else raise(ack==true? 0x18 : 0x20);
+      break;
+    }
+
+    case transmitting:
+      if (receive(TWDR)==true) raise(0x28);
+      else
+      {
+        _phase = refused;
+        raise(0x30);
+      }
+      break;
+
+    case receiving:
+      TWDR._value = send();
+      raise((control&_BV(TWEA))!=0? 0x50 : 0x58);
+      break;
+
+    case refused:
+      _statistics.protocolErrors++;
+      raise(0x30);
+      break;
+
+    default:
+      // Data without a start.
+      _statistics.protocolErrors++;
+      break;
+  }
+}
+
+
+void MLX90614Sensor::raise(uint8_t status)
+{
+  TWSR._value = (TWSR._value&0x03) | status;
+  _interrupt = true;
+}
+
+
+void MLX90614Sensor::start(void)
+{
+  if (_phase==released) _statistics.starts++;
+  else
+  {
+    _statistics.repeatedStarts++;
+    finish();
+  }
+  _phase = addressing;
+}
+
+
+void MLX90614Sensor::stop(void)
+{
+  _statistics.stops++;
+  _phase = released;
+  finish();
+  _index = 0;
+}
+
+
+// A complete write word is written if its PEC is right, at the stop or
+// the repeated start that ends it.
+void MLX90614Sensor::finish(void)
+{
+  if (_index==5 && (_frame[0]&0x01)==0)
+  {
+    if (crc(_frame,4)!=_frame[4]) _statistics.pecErrors++;
+    else if ((_frame[1]&0x20)!=0)
+    {
+      setWord(_frame[1],(_frame[3]<<8) | _frame[2]);
+      _statistics.writes++;
+    }
+    _index = 0;
+  }
+}
+
+
+// Command, LSB, MSB and PEC. Returns false for no acknowledge.
+boolean MLX90614Sensor::receive(uint8_t value)
+{
+  if (_index>=5) return false;
+  if (_index==1 && value>=0x40) return false;
+  _frame[_index++] = value;
+  return true;
+}
+
+
+// LSB, MSB and PEC, then the bus reads 1.
+uint8_t MLX90614Sensor::send(void)
+{
+  if (_index==3)
+  {
+    uint16_t value = word(_frame[1]);
+    _frame[3] = value & 0xff;
+    _frame[4] = value >> 8;
+    _frame[5] = crc(_frame,5);
+    if (_corrupt>0)
+    {
+      _frame[5] ^= 0x01;
+      _corrupt--;
+    }
+    _statistics.reads++;
+  }
+  if (_index>=6) return 0xff;
+  return _frame[_index++];
+}
+
+
+// SMBus PEC, x^8 + x^2 + x + 1 MSB first.
+uint8_t MLX90614Sensor::crc(const uint8_t *bytes, uint8_t size)
+{
+  uint8_t result = 0;
+  for (uint8_t i=0; i<size; i++)
+  {
+    result ^= bytes[i];
+    for (uint8_t j=0; j<8; j++)
+    {
+      result = (result&0x80)!=0? (result<<1) ^ 0x07 : result<<1;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,99 @@
+/*
+ * Simulated MLX90614 infrared thermometer for the host build, with a
+ * model of the TWI registers of the ATmega328 as its bus master.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __MLX90614_SENSOR_H__
+#define __MLX90614_SENSOR_H__
+
+#include "Arduino.h"
+
+
+struct MLX90614SensorStatistics
+{
+  uint16_t starts;
+  uint16_t repeatedStarts;
+  uint16_t stops;
+  uint16_t reads; // words sent to the master
+  uint16_t writes; // EEPROM words written
+  uint16_t pecErrors; // words received with a bad PEC, not written
+  uint16_t protocolErrors; // TWCR writes the bus state does not allow
+};
+
+
+// The TWI unit executes a TWCR write with TWINT set at once, bytes take
+// no simulated time. TWSR then holds the status code of the datasheet
+// and TWI_vect runs as soon as TWIE and the I bit of SREG allow it. The
+// flag is kept by the model, TWINT reads 0, so polling it does not work.
+// A stop clears TWSTO right away. Arbitration is not modelled.
+//
+// The sensor answers SMBus read word and write word with PEC. RAM is
+// read-only, EEPROM cells are written at the stop or repeated start
+// ending the write. Commands past the EEPROM are not acknowledged.
+class MLX90614Sensor : public HostDevice
+{
+public:
+  MLX90614Sensor(uint8_t address);
+
+  virtual void sync(unsigned long now);
+
+  // RAM at 0x00 to 0x1f, EEPROM at 0x20 to 0x3f.
+  void setWord(uint8_t command, uint16_t value) { _memory[command&0x3f] = value; }
+  uint16_t word(uint8_t command) { return _memory[command&0x3f]; }
+  // A sensor at another address does not acknowledge.
+  void setAddress(uint8_t address) { _address = address; }
+  // Send a bad PEC in the next reads.
+  void corruptPec(uint8_t reads) { _corrupt = reads; }
+
+  const MLX90614SensorStatistics& statistics(void) { return _statistics; }
+  void resetStatistics(void) { memset(&_statistics,0,sizeof(_statistics)); }
+
+private:
+  enum Phase
+  {
+    released,
+    addressing, // after a start, TWDR holds the address
+    transmitting, // master to sensor
+    receiving, // sensor to master
+    refused, // not acknowledged, waiting for a start or stop
+  };
+
+  uint8_t _address;
+  uint16_t _memory[0x40];
+  uint8_t _corrupt;
+
+  Phase _phase;
+  boolean _interrupt; // TWINT as seen by the hardware
+  boolean _handling; // TWI_vect is running
+  uint16_t _executed; // TWCR writes executed
+  uint8_t _frame[6]; // address, command, address, LSB, MSB, PEC
+  uint8_t _index;
+  MLX90614SensorStatistics _statistics;
+
+  void execute(void);
+  void raise(uint8_t status);
+  void start(void);
+  void stop(void);
+  void finish(void);
+  boolean receive(uint8_t value);
+  uint8_t send(void);
+  static uint8_t crc(const uint8_t *bytes, uint8_t size);
+};
+
+
+#endif /* __MLX90614_SENSOR_H__ */
@@ -0,0 +1,305 @@
+/*
+ * Simulated SHT1x humidity and temperature sensor for the host build,
+ * bit-level model of the two-wire interface.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "sht1x_sensor.h"
+
+
+#define CMD_MEASURE_TEMPERATURE  0x03
+#define CMD_MEASURE_HUMIDITY  0x05
+#define CMD_READ_STATUS  0x07
+#define CMD_WRITE_STATUS  0x06
+#define CMD_SOFT_RESET  0x1e
+
+#define NEVER  ((unsigned long)-1)
+
+
+// x^8 + x^5 + x^4 + 1, MSB first, computed bit by bit to be independent
+// of the lookup tables of the driver.
+static uint8_t crc8(uint8_t crc, uint8_t value)
+{
+  for (uint8_t i=0; i<8; i++)
+  {
+    uint8_t feedback = (crc^value)&0x80;
+    crc <<= 1;
+    value <<= 1;
+    if (feedback!=0) crc ^= 0x31;
+  }
+  return crc;
+}
+
+
+static uint8_t reverse(uint8_t value)
+{
+  uint8_t result = 0;
+  for (uint8_t i=0; i<8; i++)
+  {
+    result = (result<<1) | ((value>>i)&0x01);
+  }
+  return result;
+}
+
+
+SHT1x_sensor::SHT1x_sensor(uint8_t data, uint8_t sck) :
+  _data(data),
+  _sck(sck),
+  _raw_temperature(0),
+  _raw_humidity(0),
+  _corrupt(0),
+  _present(true),
+  _status(0),
+  _state(idle),
+  _command(0),
+  _shift(0),
+  _bit(0),
+  _length(0),
+  _index(0),
+  _ready(0),
+  _start(0),
+  _high_clocks(0),
+  _sck_level(0),
+  _master_level(1),
+  _output(1),
+  _next_output(1),
+  _output_time(0),
+  _sck_time(NEVER),
+  _data_time(NEVER),
+  _starts(0),
+  _resets(0),
+  _measurements(0),
+  _timing_errors(0),
+  _protocol_errors(0),
+  _clocks(0)
+{
+}
+
+
+void SHT1x_sensor::set_raw(uint16_t temperature, uint16_t humidity)
+{
+  _raw_temperature = temperature;
+  _raw_humidity = humidity;
+}
+
+
+void SHT1x_sensor::sync(unsigned long now)
+{
+  if (_state==measure && now>=_ready)
+  {
+    // Measurement done, DATA low and the first bit of the frame.
+    _state = send;
+    _index = 0;
+    _bit = 0;
+    _shift = _frame[0];
+    _output = 0;
+    _next_output = 0;
+  }
+  if (now>=_output_time) _output = _next_output;
+
+  uint8_t master = hostPinDriven(_data)!=0; // an input is pulled up
+  uint8_t sck = hostPinDriven(_sck)==1;
+  if (master!=_master_level)
+  {
+    _master_level = master;
+    data_change(now);
+    _data_time = now;
+  }
+  if (sck!=_sck_level)
+  {
+    _sck_level = sck;
+    if (now==_sck_time) _timing_errors++;
+    if (sck!=0) rising_edge(now);
+    else falling_edge(now);
+    _sck_time = now;
+  }
+  hostPinInput(_data,_master_level&_output);
+}
+
+
+void SHT1x_sensor::data_change(unsigned long now)
+{
+  if (_sck_level==0) return;
+  if (_master_level==0)
+  {
+    // First half of a transmission start, aborts any transfer.
+    _start = 1;
+    _state = idle;
+    _output = 1;
+    _next_output = 1;
+  }
+  else if (_start==2)
+  {
+    _start = 0;
+    _starts++;
+    _state = receive_command;
+    _shift = 0;
+    _bit = 0;
+  }
+  else
+  {
+    _start = 0;
+    _protocol_errors++;
+  }
+}
+
+
+void SHT1x_sensor::rising_edge(unsigned long now)
+{
+  _clocks++;
+  if (now==_data_time) _timing_errors++;
+  if (_start==1) _start = 2;
+
+  if ((_master_level&_output)!=0)
+  {
+    if (++_high_clocks==9)
+    {
+      // Connection reset.
+      _resets++;
+      _state = idle;
+    }
+  }
+  else _high_clocks = 0;
+
+  if (_state==idle || _state==measure) return;
+  _bit++;
+  if ((_state==receive_command || _state==receive_status) && _bit<=8)
+  {
+    _shift = (_shift<<1) | _master_level;
+  }
+  else if (_state==send && _bit==9 && _master_level!=0)
+  {
+    // No acknowledge, the master skips the rest of the frame.
+    _index = _length;
+  }
+}
+
+
+void SHT1x_sensor::falling_edge(unsigned long now)
+{
+  if (_state==idle || _state==measure) return;
+  if (_state==send)
+  {
+    if (_bit<8) output((_shift>>(7-_bit))&0x01,now);
+    else if (_bit==8) output(1,now); // the master acknowledges
+    else if (++_index<_length)
+    {
+      _bit = 0;
+      _shift = _frame[_index];
+      output(_shift>>7,now);
+    }
+    else _state = idle;
+    return;
+  }
+
+  if (_bit==8)
+  {
+    boolean valid = _state==receive_status;
+    if (_state==receive_command)
+    {
+      valid = _shift==CMD_MEASURE_TEMPERATURE || _shift==CMD_MEASURE_HUMIDITY ||
+              _shift==CMD_READ_STATUS || _shift==CMD_WRITE_STATUS || _shift==CMD_SOFT_RESET;
+    }
+    if (valid==true && _present==true) output(0,now);
+    else _state = idle;
+  }
+  else if (_bit==9)
+  {
+    output(1,now);
+    if (_state==receive_status)
+    {
+      _status = _shift&0x07;
+      _state = idle;
+      return;
+    }
+    _command = _shift;
+    _bit = 0;
+    _shift = 0;
+    command();
+    if (_state==measure) _ready = now + 1000UL*_ready;
+    else if (_state==send) output(_shift>>7,now);
+  }
+}
+
+
+void SHT1x_sensor::command(void)
+{
+  boolean low = (_status&0x01)!=0;
+  switch (_command)
+  {
+    case CMD_MEASURE_TEMPERATURE:
+      frame(_command,_raw_temperature&(low? 0x0fff : 0x3fff),3);
+      _ready = low? SHT1X_SENSOR_12BIT_MS : SHT1X_SENSOR_14BIT_MS;
+      _state = measure;
+      _measurements++;
+      break;
+
+    case CMD_MEASURE_HUMIDITY:
+      frame(_command,_raw_humidity&(low? 0x00ff : 0x0fff),3);
+      _ready = low? SHT1X_SENSOR_8BIT_MS : SHT1X_SENSOR_12BIT_MS;
+      _state = measure;
+      _measurements++;
+      break;
+
+    case CMD_READ_STATUS:
+      frame(_command,_status,2);
+      _shift = _frame[0];
+      _state = send;
+      break;
+
+    case CMD_WRITE_STATUS:
+      _state = receive_status;
+      break;
+
+    case CMD_SOFT_RESET:
+      _status = 0;
+      _state = idle;
+      break;
+  }
+}
+
+
+// The sensor changes DATA 250 ns after the falling edge of SCK.
+void SHT1x_sensor::output(uint8_t level, unsigned long now)
+{
+  _next_output = level;
+  _output_time = now + 1;
+}
+
+
+// Value (one or two bytes) and CRC. The CRC starts from the reversed low
+// nibble of the status register and covers the command too, it is sent
+// reversed.
+void SHT1x_sensor::frame(uint8_t command, uint16_t value, uint8_t size)
+{
+  uint8_t crc = reverse(_status&0x0f);
+  crc = crc8(crc,command);
+  _length = 0;
+  if (size==3) _frame[_length++] = value>>8;
+  _frame[_length++] = value;
+  for (uint8_t i=0; i<_length; i++)
+  {
+    crc = crc8(crc,_frame[i]);
+  }
+  if (_corrupt>0 && size==3)
+  {
+    _corrupt--;
+    crc ^= 0x01;
+  }
+  _frame[_length++] = reverse(crc);
+  _index = 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Simulated SHT1x humidity and temperature sensor for the host build,
+ * bit-level model of the two-wire interface.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __SHT1X_SENSOR_H__
+#define __SHT1X_SENSOR_H__
+
+#include "Arduino.h"
+
+
+// Typical measurement times.
+#define SHT1X_SENSOR_14BIT_MS  210
+#define SHT1X_SENSOR_12BIT_MS  55
+#define SHT1X_SENSOR_8BIT_MS  11
+
+
+// The sensor samples DATA on the rising edge of SCK and changes it
+// after the falling edge, valid 250 ns later. At the 1 us resolution of
+// the host build: its output changes 1 us after the falling edge, and
+// SCK edges or a DATA change and the next rising edge in the same
+// microsecond break the 100 ns minimum high, low and setup times.
+// DATA may only change while SCK is high for a transmission start.
+class SHT1x_sensor : public HostDevice
+{
+public:
+  SHT1x_sensor(uint8_t data, uint8_t sck);
+
+  virtual void sync(unsigned long now);
+
+  // Raw values returned by the next measurements.
+  void set_raw(uint16_t temperature, uint16_t humidity);
+  // Send a bad CRC in the next frames.
+  void corrupt(uint8_t frames) { _corrupt = frames; }
+  // A missing sensor does not acknowledge.
+  void set_present(boolean present) { _present = present; }
+
+  uint8_t get_status(void) { return _status; }
+  uint8_t get_command(void) { return _command; } // last command acknowledged
+  uint16_t get_starts(void) { return _starts; } // transmission starts
+  uint16_t get_resets(void) { return _resets; } // connection resets
+  uint16_t get_measurements(void) { return _measurements; }
+  uint16_t get_timing_errors(void) { return _timing_errors; }
+  uint16_t get_protocol_errors(void) { return _protocol_errors; }
+  uint32_t get_clocks(void) { return _clocks; }
+
+private:
+  enum state
+  {
+    idle,
+    receive_command,
+    measure,
+    receive_status,
+    send,
+  };
+
+  uint8_t _data;
+  uint8_t _sck;
+  uint16_t _raw_temperature;
+  uint16_t _raw_humidity;
+  uint8_t _corrupt;
+  boolean _present;
+  uint8_t _status;
+
+  state _state;
+  uint8_t _command;
+  uint8_t _shift; // byte being received or sent
+  uint8_t _bit; // bits of the byte done, 8 is the acknowledge
+  uint8_t _frame[3];
+  uint8_t _length; // bytes in the frame
+  uint8_t _index;
+  unsigned long _ready; // end of the measurement
+  uint8_t _start; // 1: DATA fell while SCK high, 2: SCK cycled since
+  uint8_t _high_clocks; // consecutive clocks with DATA high
+
+  uint8_t _sck_level;
+  uint8_t _master_level; // DATA as driven by the Arduino
+  uint8_t _output; // DATA as driven by the sensor, 0 pulls low
+  uint8_t _next_output;
+  unsigned long _output_time; // when _next_output is valid
+  unsigned long _sck_time;
+  unsigned long _data_time;
+
+  uint16_t _starts;
+  uint16_t _resets;
+  uint16_t _measurements;
+  uint16_t _timing_errors;
+  uint16_t _protocol_errors;
+  uint32_t _clocks;
+
+  void rising_edge(unsigned long now);
+  void falling_edge(unsigned long now);
+  void data_change(unsigned long now);
+  void command(void);
+  void output(uint8_t level, unsigned long now);
+  void frame(uint8_t command, uint16_t value, uint8_t size);
+};
+
+
+#endif /* __SHT1X_SENSOR_H__ */
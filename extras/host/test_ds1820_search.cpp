@@ -0,0 +1,145 @@
+/*
+ * DS1820 driver against simulated DS18B20 chips on the shield's 1-Wire
+ * pin: ROM search with codes sharing long prefixes, Match ROM reads of
+ * every chip and the resolution setting.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "ds1820.h"
+#include "ds18b20.h"
+#include "check.h"
+
+
+// The last byte is replaced by the CRC. Apart from the fourth code they
+// only differ in the last byte of the serial number, from bit 48 on.
+static const uint8_t roms[][8] =
+{
+  { 0x28, 0x11, 0x22, 0x33, 0x44, 0x55, 0x06, 0 },
+  { 0x28, 0x11, 0x22, 0x33, 0x44, 0x55, 0x86, 0 },
+  { 0x28, 0x11, 0x22, 0x33, 0x44, 0x55, 0x07, 0 },
+  { 0x28, 0x91, 0x22, 0x33, 0x44, 0x55, 0x06, 0 },
+  { 0x28, 0x11, 0x22, 0x33, 0x44, 0x55, 0x46, 0 },
+};
+
+// 25.0625, -10.5, 85, 0.125 and 20 degrees in 1/16 degrees.
+static const int16_t temperatures[] = { 401, -168, 1360, 2, 320 };
+
+
+// Index of the simulated chip with this ROM code, -1 if none.
+static int chipOf(DS18B20Bus& bus, const uint8_t *rom)
+{
+  for (uint8_t i=0; i<bus.chips(); i++)
+  {
+    if (memcmp(bus.rom(i),rom,DS1820_ROM_SIZE)==0) return i;
+  }
+  return -1;
+}
+
+
+static void testSearch(uint8_t chips)
+{
+  DS18B20Bus bus(DDRB,PORTB,PINB,DS1820_DEFAULT_BIT);
+  DS1820 thermometer;
+  for (uint8_t i=0; i<chips; i++)
+  {
+    bus.add(roms[i],temperatures[i]);
+  }
+
+  // Every chip is found once.
+  uint8_t found = min(chips,DS1820_MAX_DEVICES);
+  CHECK_EQUAL(found,thermometer.search());
+  CHECK_EQUAL(found,thermometer.devices());
+  uint8_t seen = 0;
+  for (uint8_t i=0; i<thermometer.devices(); i++)
+  {
+    int chip = chipOf(bus,thermometer.rom(i));
+    CHECK(chip>=0);
+    if (chip>=0)
+    {
+      CHECK((seen&_BV(chip))==0);
+      seen |= _BV(chip);
+    }
+  }
+
+  // Match ROM reads the right chip.
+  float result[DS1820_MAX_DEVICES];
+  CHECK_EQUAL(found,thermometer.readAll(result,DS1820_MAX_DEVICES));
+  for (uint8_t i=0; i<found; i++)
+  {
+    int chip = chipOf(bus,thermometer.rom(i));
+    if (chip<0) continue;
+    CHECK(result[i]==temperatures[chip]/16.0);
+    int16_t centi;
+    CHECK_EQUAL(DS1820_OK,thermometer.readResultCenti(centi,i));
+    CHECK_EQUAL((temperatures[chip]*25+(temperatures[chip]<0? -2 : 2))/4,centi);
+  }
+
+  // Every chip is configured, the low bits are masked below 12 bits. A
+  // chip missing from the device table would keep 12 bits and make the
+  // shorter wait time out.
+  if (chips<=DS1820_MAX_DEVICES)
+  {
+    CHECK(thermometer.setResolution(10)==true);
+    for (uint8_t i=0; i<chips; i++)
+    {
+      CHECK_EQUAL(10,bus.resolution(i));
+    }
+    CHECK_EQUAL(found,thermometer.readAll(result,DS1820_MAX_DEVICES));
+    for (uint8_t i=0; i<found; i++)
+    {
+      int chip = chipOf(bus,thermometer.rom(i));
+      if (chip>=0) CHECK(result[i]==(temperatures[chip]&~0x03)/16.0);
+    }
+  }
+
+  CHECK_EQUAL(0,bus.statistics().timingErrors);
+}
+
+
+int main(void)
+{
+  testSearch(1);
+  testSearch(3);
+  testSearch(DS1820_MAX_DEVICES);
+  // More chips than the device table holds.
+  testSearch(5);
+
+  {
+    // A ROM code nobody has selects no chip, the bus reads all ones.
+    DS18B20Bus bus(DDRB,PORTB,PINB,DS1820_DEFAULT_BIT);
+    DS1820 thermometer;
+    bus.add(roms[0],temperatures[0]);
+    CHECK_EQUAL(1,thermometer.search());
+    uint8_t *rom = const_cast<uint8_t *>(thermometer.rom(0));
+    rom[6] ^= 0x01;
+    int16_t centi;
+    CHECK_EQUAL(DS1820_CRC_ERROR,thermometer.readResultCenti(centi,0));
+    rom[6] ^= 0x01;
+    CHECK_EQUAL(DS1820_OK,thermometer.readCenti(centi));
+    CHECK_EQUAL(2506,centi);
+  }
+  {
+    // Without chips there is no presence pulse.
+    DS18B20Bus bus(DDRB,PORTB,PINB,DS1820_DEFAULT_BIT);
+    DS1820 thermometer;
+    CHECK_EQUAL(0,thermometer.search());
+    int16_t centi;
+    CHECK_EQUAL(DS1820_NO_DEVICE,thermometer.readCenti(centi));
+  }
+  return report();
+}
@@ -0,0 +1,91 @@
+/*
+ * Shadow buffer against the HD44780 model: clear() and home() only touch
+ * the mirror unless the display is larger than the shadow buffer or was
+ * shifted, then the controller has to execute them too.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "LiquidCrystal.h"
+#include "hd44780.h"
+#include "check.h"
+
+
+#define PIN_RS  6
+#define PIN_RW  8
+#define PIN_E  7
+
+
+int main(void)
+{
+  HD44780 sim(PIN_RS,PIN_RW,PIN_E,5,4,3,2);
+  LiquidCrystal lcd(PIN_RS,PIN_RW,PIN_E,5,4,3,2);
+  char row[21];
+
+  // The shield display fits the shadow buffer, clear() and home() cost
+  // nothing and flush() blanks what was written.
+  lcd.begin(16,2);
+  lcd.shadowBuffer();
+  lcd.print("shadow");
+  lcd.flush();
+  CHECK_STRING("shadow          ",sim.row(0,row,16));
+  sim.resetStatistics();
+  lcd.clear();
+  lcd.home();
+  CHECK_EQUAL(0,sim.statistics().commands);
+  lcd.flush();
+  CHECK_STRING("                ",sim.row(0,row,16));
+
+  // A shifted display is shifted back.
+  lcd.print("left");
+  lcd.flush();
+  lcd.scrollDisplayLeft();
+  CHECK_EQUAL(1,sim.shift());
+  lcd.home();
+  CHECK_EQUAL(0,sim.shift());
+  CHECK_STRING("left            ",sim.row(0,row,16));
+  lcd.scrollDisplayRight();
+  lcd.clear();
+  lcd.flush();
+  CHECK_EQUAL(0,sim.shift());
+  CHECK_STRING("                ",sim.row(0,row,16));
+  // Once back, the mirror is in sync again.
+  sim.resetStatistics();
+  lcd.home();
+  CHECK_EQUAL(0,sim.statistics().commands);
+  lcd.print("back");
+  lcd.flush();
+  CHECK_STRING("back            ",sim.row(0,row,16));
+
+  // The columns beyond the shadow buffer are cleared by the controller.
+  lcd.begin(20,2);
+  lcd.shadowBuffer();
+  lcd.print("0123456789abcdefghij");
+  lcd.setCursor(0,1);
+  lcd.print("klmnopqrstuvwxyz!?#$");
+  lcd.flush();
+  CHECK_STRING("0123456789abcdefghij",sim.row(0,row,20));
+  CHECK_STRING("klmnopqrstuvwxyz!?#$",sim.row(1,row,20));
+  lcd.clear();
+  lcd.print("wide");
+  lcd.flush();
+  CHECK_STRING("wide                ",sim.row(0,row,20));
+  CHECK_STRING("                    ",sim.row(1,row,20));
+
+  CHECK_EQUAL(0,sim.statistics().dropped);
+  return report();
+}
@@ -0,0 +1,141 @@
+/*
+ * Busy flag polling against the HD44780 timing model: clear and home
+ * take 1.52 ms, other instructions 37 us. Polling returns as soon as the
+ * controller is ready, never before, and gives up after the worst-case
+ * time.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "LiquidCrystal.h"
+#include "hd44780.h"
+#include "check.h"
+
+
+#define PIN_RS  6
+#define PIN_RW  8
+#define PIN_E  7
+
+
+// Time a call takes, in microseconds.
+template <class Call>
+static unsigned long elapsed(Call call)
+{
+  unsigned long start = hostMicros();
+  call();
+  return hostMicros() - start;
+}
+
+
+static void testTiming(LiquidCrystal& lcd, HD44780& sim)
+{
+  char row[17];
+  lcd.begin(16,2);
+  sim.resetStatistics();
+
+  // Fixed delays: 2 ms for clear and home, 100 us per nibble.
+  unsigned long fixedClear = elapsed([&]{ lcd.clear(); });
+  unsigned long fixedHome = elapsed([&]{ lcd.home(); });
+  unsigned long fixedCommand = elapsed([&]{ lcd.display(); });
+  unsigned long fixedWrite = elapsed([&]{ lcd.write('A'); });
+  CHECK(fixedClear>=2000);
+  CHECK(fixedHome>=2000);
+
+  lcd.busyFlag();
+  unsigned long clear = elapsed([&]{ lcd.clear(); });
+  CHECK(sim.busy()==false);
+  CHECK(clear>=HD44780_CLEAR_US);
+  CHECK(clear<HD44780_CLEAR_US+200);
+  CHECK(clear<fixedClear);
+
+  unsigned long write = elapsed([&]{ lcd.write('H'); });
+  CHECK(sim.busy()==false);
+  CHECK(write<fixedWrite);
+  lcd.print("ello");
+
+  unsigned long home = elapsed([&]{ lcd.home(); });
+  CHECK(sim.busy()==false);
+  CHECK(home>=HD44780_CLEAR_US);
+  CHECK(home<fixedHome);
+  lcd.write('J');
+
+  unsigned long command = elapsed([&]{ lcd.display(); });
+  CHECK(sim.busy()==false);
+  CHECK(command<fixedCommand);
+
+  // Nothing written too early was lost.
+  lcd.setCursor(0,1);
+  lcd.print("0123456789abcdef");
+  CHECK_EQUAL(0,sim.statistics().dropped);
+  CHECK_STRING("Jello           ",sim.row(0,row,16));
+  CHECK_STRING("0123456789abcdef",sim.row(1,row,16));
+
+  // A faster controller is polled for a shorter time.
+  sim.setTiming(20,800);
+  clear = elapsed([&]{ lcd.clear(); });
+  CHECK(clear>=800);
+  CHECK(clear<1000);
+  lcd.print("fast");
+  CHECK_EQUAL(0,sim.statistics().dropped);
+  CHECK_STRING("fast            ",sim.row(0,row,16));
+
+  // The queue polls the busy flag too.
+  sim.setTiming(HD44780_COMMAND_US,HD44780_CLEAR_US);
+  lcd.asyncQueue();
+  lcd.clear();
+  lcd.print("queued");
+  lcd.setCursor(10,1);
+  lcd.print("busy");
+  lcd.noAsyncQueue();
+  CHECK_EQUAL(0,sim.statistics().dropped);
+  CHECK_STRING("queued          ",sim.row(0,row,16));
+  CHECK_STRING("          busy  ",sim.row(1,row,16));
+
+  // A controller that never gets ready does not hang the sketch, send()
+  // gives up after 100 us and clear() after 2 ms.
+  sim.setTiming(HD44780_COMMAND_US,10000);
+  clear = elapsed([&]{ lcd.clear(); });
+  CHECK(clear>=2100);
+  CHECK(clear<2100+200);
+  delay(10);
+  sim.setTiming(HD44780_COMMAND_US,HD44780_CLEAR_US);
+  lcd.noBusyFlag();
+}
+
+
+int main(void)
+{
+  {
+    // Shield pinout with RW connected.
+    HD44780 sim(PIN_RS,PIN_RW,PIN_E,5,4,3,2);
+    LiquidCrystal lcd(PIN_RS,PIN_RW,PIN_E,5,4,3,2);
+    testTiming(lcd,sim);
+  }
+  {
+    HD44780 sim(PIN_RS,PIN_RW,PIN_E,9,10,11,12,13,14,15,16);
+    LiquidCrystal lcd(PIN_RS,PIN_RW,PIN_E,9,10,11,12,13,14,15,16);
+    testTiming(lcd,sim);
+  }
+  {
+    // Without RW there is no busy flag to read.
+    HD44780 sim(PIN_RS,255,PIN_E,5,4,3,2);
+    LiquidCrystal lcd(PIN_RS,PIN_E,5,4,3,2);
+    lcd.busyFlag();
+    CHECK(elapsed([&]{ lcd.clear(); })>=2000);
+  }
+  return report();
+}
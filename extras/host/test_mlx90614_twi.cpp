@@ -0,0 +1,123 @@
+/*
+ * Interrupt driven MLX90614 driver against the TWI register model: PEC
+ * checked reads, no acknowledge for the address or a data byte, queued
+ * transfers joined by repeated starts and EEPROM writes.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "mlx90614.h"
+#include "mlx90614_sensor.h"
+#include "check.h"
+
+
+// 25.01, 36.59 and -20.15 degrees in 0.02 K.
+#define RAW_AMBIENT  14908
+#define RAW_OBJECT1  15487
+#define RAW_OBJECT2  12650
+
+
+int main(void)
+{
+  MLX90614Sensor sensor(MLX90614_ADDRESS);
+  MLX90614 mlx90614;
+  sensor.setWord(MLX90614_RAM_AMBIENT,RAW_AMBIENT);
+  sensor.setWord(MLX90614_RAM_OBJECT1,RAW_OBJECT1);
+  sensor.setWord(MLX90614_RAM_OBJECT2,RAW_OBJECT2);
+  sensor.setWord(MLX90614_EEPROM|MLX90614_EEPROM_EMISSIVITY,0xffff);
+  mlx90614.begin(SDA,SCL);
+
+  // Write word, repeated start, read word, then the stop.
+  int16_t centi;
+  CHECK_EQUAL(MLX90614_OK,mlx90614.readCenti(centi));
+  CHECK_EQUAL(3659,centi);
+  CHECK_EQUAL(1,sensor.statistics().starts);
+  CHECK_EQUAL(1,sensor.statistics().repeatedStarts);
+  CHECK_EQUAL(1,sensor.statistics().stops);
+  CHECK_EQUAL(1,sensor.statistics().reads);
+
+  // A bad PEC is caught, the next read is fine again.
+  sensor.corruptPec(1);
+  CHECK_EQUAL(MLX90614_PEC_ERROR,mlx90614.readCenti(centi));
+  CHECK_EQUAL(0,centi);
+  CHECK_EQUAL(MLX90614_OK,mlx90614.readCenti(centi));
+  CHECK_EQUAL(3659,centi);
+
+  // Nobody at the address, the bus is released.
+  uint16_t value;
+  sensor.resetStatistics();
+  sensor.setAddress(MLX90614_ADDRESS+1);
+  CHECK_EQUAL(MLX90614_BUS_ERROR,mlx90614.readWord(MLX90614_RAM_AMBIENT,value));
+  CHECK_EQUAL(0,value);
+  CHECK_EQUAL(1,sensor.statistics().stops);
+  sensor.setAddress(MLX90614_ADDRESS);
+
+  // A command the sensor does not know is not acknowledged.
+  CHECK_EQUAL(MLX90614_BUS_ERROR,mlx90614.readWord(0xf0,value));
+  CHECK_EQUAL(2,sensor.statistics().stops);
+  CHECK_EQUAL(MLX90614_OK,mlx90614.readWord(MLX90614_RAM_AMBIENT,value));
+  CHECK_EQUAL(RAW_AMBIENT,value);
+
+  // Transfers queued with interrupts off are joined by repeated starts.
+  // After an error the bus is released before the next one.
+  MLX90614Transfer t[4] =
+  {
+    { MLX90614_RAM_AMBIENT, false, 0, MLX90614_OK },
+    { MLX90614_RAM_OBJECT1, false, 0, MLX90614_OK },
+    { 0xf0, false, 0, MLX90614_OK },
+    { MLX90614_RAM_OBJECT2, false, 0, MLX90614_OK },
+  };
+  sensor.resetStatistics();
+  cli();
+  for (uint8_t i=0; i<4; i++)
+  {
+    CHECK(mlx90614.submit(t[i])==false);
+  }
+  MLX90614Transfer full = { MLX90614_RAM_AMBIENT, false, 0, MLX90614_OK };
+  CHECK(mlx90614.submit(full)==true);
+  CHECK_EQUAL(MLX90614_BUSY,t[0].status);
+  sei();
+  CHECK_EQUAL(MLX90614_OK,t[0].status);
+  CHECK_EQUAL(RAW_AMBIENT,t[0].value);
+  CHECK_EQUAL(MLX90614_OK,t[1].status);
+  CHECK_EQUAL(RAW_OBJECT1,t[1].value);
+  CHECK_EQUAL(MLX90614_BUS_ERROR,t[2].status);
+  CHECK_EQUAL(MLX90614_OK,t[3].status);
+  CHECK_EQUAL(RAW_OBJECT2,t[3].value);
+  CHECK_EQUAL(2,sensor.statistics().starts);
+  CHECK_EQUAL(3+2,sensor.statistics().repeatedStarts);
+  CHECK_EQUAL(2,sensor.statistics().stops);
+
+  MLX90614Temperatures all;
+  CHECK_EQUAL(MLX90614_OK,mlx90614.readAll(all));
+  CHECK_EQUAL(RAW_AMBIENT,all.ambient);
+  CHECK_EQUAL(RAW_OBJECT1,all.object1);
+  CHECK_EQUAL(RAW_OBJECT2,all.object2);
+
+  // Write word with PEC: erase, write, read back. An unchanged value is
+  // not written.
+  sensor.resetStatistics();
+  CHECK_EQUAL(MLX90614_OK,mlx90614.setEmissivity(0xf332));
+  CHECK_EQUAL(0xf332,sensor.word(MLX90614_EEPROM|MLX90614_EEPROM_EMISSIVITY));
+  CHECK_EQUAL(2,sensor.statistics().writes);
+  CHECK_EQUAL(MLX90614_OK,mlx90614.setEmissivity(0xf332));
+  CHECK_EQUAL(2,sensor.statistics().writes);
+  CHECK_EQUAL(0,sensor.statistics().pecErrors);
+
+  CHECK_EQUAL(0,sensor.statistics().protocolErrors);
+  return report();
+}
@@ -0,0 +1,112 @@
+/*
+ * OneWireBus on a mock port: reset and presence, write and read slots,
+ * and a DS1820 on top of it next to the default bus.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "onewire.h"
+#include "ds1820.h"
+#include "ds18b20.h"
+#include "check.h"
+
+
+// Registers of no real port.
+static HostRegister mockDdr, mockPort, mockPin;
+ONEWIRE_PORT(MockPort,mockDdr,mockPort,mockPin);
+#define MOCK_BIT  3
+
+static const uint8_t rom[8] = { 0x28, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0 };
+
+
+// Time a call takes, in microseconds.
+template <class Call>
+static unsigned long elapsed(Call call)
+{
+  unsigned long start = hostMicros();
+  call();
+  return hostMicros() - start;
+}
+
+
+int main(void)
+{
+  OneWireBus<MockPort,MOCK_BIT> bus;
+  DS18B20Bus chips(mockDdr,mockPort,mockPin,MOCK_BIT);
+
+  // Nobody answers an empty bus. The master holds the reset pulse for
+  // 500 us and waits 480 us for the presence pulse.
+  boolean presence = true;
+  CHECK(elapsed([&]{ presence = bus.reset(); })>=500+480);
+  CHECK(presence==false);
+  CHECK_EQUAL(1,chips.statistics().resets);
+
+  chips.add(rom,401);
+  CHECK(bus.reset()==true);
+  // The bus is released between slots.
+  CHECK((mockDdr&_BV(MOCK_BIT))==0);
+
+  // Write slots: Skip ROM, Write Scratchpad with TH, TL and 10 bits.
+  chips.resetStatistics();
+  unsigned long slot = elapsed([&]{ CHECK_EQUAL(1,bus.timeSlot(1)); });
+  CHECK(slot>=DS18B20_WRITE0_US);
+  CHECK(slot<=DS18B20_SLOT_US);
+  CHECK(bus.reset()==true);
+  bus.writeByte(0xcc);
+  bus.writeByte(0x4e);
+  bus.writeByte(0x55);
+  bus.writeByte(0xaa);
+  bus.writeByte(0x3f);
+  CHECK_EQUAL(10,chips.resolution(0));
+  CHECK_EQUAL(1+5*8,chips.statistics().slots);
+
+  // Read slots: the scratchpad as written, with a valid CRC.
+  uint8_t scratchpad[DS1820_SCRATCHPAD_SIZE];
+  CHECK(bus.reset()==true);
+  bus.writeByte(0xcc);
+  bus.writeByte(0xbe);
+  uint8_t crc = 0;
+  for (uint8_t i=0; i<DS1820_SCRATCHPAD_SIZE; i++)
+  {
+    scratchpad[i] = bus.readByte();
+    crc = crc8_dallas(crc,scratchpad[i]);
+  }
+  CHECK_EQUAL(0x55,scratchpad[2]);
+  CHECK_EQUAL(0xaa,scratchpad[3]);
+  CHECK_EQUAL(0x3f,scratchpad[4]);
+  CHECK_EQUAL(0,crc);
+  // Past the scratchpad the bus reads 1.
+  CHECK_EQUAL(0xff,bus.readByte());
+
+  // A DS1820 on the mock bus, independent of the one on the shield pin.
+  DS18B20Bus shieldChips(DDRB,PORTB,PINB,DS1820_DEFAULT_BIT);
+  DS1820 mock(bus);
+  DS1820 shield;
+  int16_t centi;
+  CHECK_EQUAL(DS1820_OK,mock.readCenti(centi));
+  CHECK_EQUAL(2500,centi); // 10 bits
+  CHECK_EQUAL(DS1820_NO_DEVICE,shield.readCenti(centi));
+  shieldChips.add(rom,-168);
+  CHECK_EQUAL(DS1820_OK,shield.readCenti(centi));
+  CHECK_EQUAL(-1050,centi);
+  CHECK_EQUAL(DS1820_OK,mock.readCenti(centi));
+  CHECK_EQUAL(2500,centi);
+
+  CHECK_EQUAL(0,chips.statistics().timingErrors);
+  CHECK_EQUAL(0,shieldChips.statistics().timingErrors);
+  return report();
+}
@@ -0,0 +1,111 @@
+/*
+ * SHT1x driver against the bit-level sensor model: start sequence,
+ * acknowledges, measurement frames and CRC. Built twice, with and
+ * without __SHT1X_FAST_IO__, the model counts clock edges and data
+ * changes that come too close together.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+#include "SHT1x.h"
+#include "sht1x_sensor.h"
+#include "check.h"
+
+
+// Same pins as the shield.
+#define PIN_DATA  SDA
+#define PIN_SCK  SCL
+
+#ifdef __SHT1X_FAST_IO__
+#define FRAME_US  150 /* 27 clocks */
+#else
+#define FRAME_US  600
+#endif /* __SHT1X_FAST_IO__ */
+
+
+// Time a call takes, in microseconds.
+template <class Call>
+static unsigned long elapsed(Call call)
+{
+  unsigned long start = hostMicros();
+  call();
+  return hostMicros() - start;
+}
+
+
+int main(void)
+{
+  SHT1x_sensor sensor(PIN_DATA,PIN_SCK);
+  SHT1x sht11;
+
+  // Connection reset and start, then the status register is read.
+  sht11.begin(PIN_DATA,PIN_SCK,true);
+  CHECK(sensor.get_resets()>=1);
+  CHECK_EQUAL(2,sensor.get_starts());
+  CHECK_EQUAL(0x07,sensor.get_command());
+  CHECK_EQUAL(0,sht11.get_status());
+
+  // One temperature frame.
+  sensor.set_raw(6400,1500);
+  CHECK(sht11.start_temperature()==false);
+  CHECK_EQUAL(3,sensor.get_starts());
+  CHECK_EQUAL(0x03,sensor.get_command());
+  CHECK(sht11.poll()==false);
+  delay(SHT1X_SENSOR_14BIT_MS-1);
+  CHECK(sht11.poll()==false);
+  delay(1);
+  unsigned long frame = elapsed([&]{ CHECK(sht11.poll()==true); });
+  CHECK(frame<FRAME_US);
+  CHECK(sht11.result_error()==false);
+  CHECK_EQUAL(2390,sht11.get_temperature_centi());
+
+  // Both measurements.
+  unsigned long update = elapsed([&]{ CHECK(sht11.update()==false); });
+  CHECK(update>=1000UL*(SHT1X_SENSOR_14BIT_MS+SHT1X_SENSOR_12BIT_MS));
+  CHECK(update<1000UL*(SHT1X_SENSOR_14BIT_MS+SHT1X_SENSOR_12BIT_MS+2));
+  CHECK_EQUAL(2390,sht11.get_temperature_centi());
+  CHECK_EQUAL(4940,sht11.get_humidity_centi());
+
+  // The resolution goes to the status register, the CRC includes it.
+  CHECK(sht11.set_resolution(true)==false);
+  CHECK_EQUAL(SHT1X_STATUS_LOW_RESOLUTION,sensor.get_status());
+  sensor.set_raw(1600,100);
+  update = elapsed([&]{ CHECK(sht11.update()==false); });
+  CHECK(update<1000UL*(SHT1X_SENSOR_12BIT_MS+SHT1X_SENSOR_8BIT_MS+2));
+  CHECK_EQUAL(2390,sht11.get_temperature_centi());
+  CHECK_EQUAL(SHT1X_STATUS_LOW_RESOLUTION,sht11.get_status());
+
+  // A corrupt frame is measured again.
+  sht11.reset_counters();
+  sensor.corrupt(1);
+  CHECK(sht11.update()==false);
+  CHECK_EQUAL(1,sht11.get_counters().crc_errors);
+  CHECK_EQUAL(1,sht11.get_counters().retries);
+  CHECK_EQUAL(2390,sht11.get_temperature_centi());
+
+  // Without a sensor nothing is acknowledged.
+  sht11.reset_counters();
+  sensor.set_present(false);
+  CHECK(sht11.update()==true);
+  CHECK_EQUAL(2*(1+SHT1X_RETRIES),sht11.get_counters().ack_errors);
+  sensor.set_present(true);
+  CHECK(sht11.update()==false);
+
+  CHECK_EQUAL(0,sensor.get_timing_errors());
+  CHECK_EQUAL(0,sensor.get_protocol_errors());
+  return report();
+}
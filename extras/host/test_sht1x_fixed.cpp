@@ -0,0 +1,74 @@
+/*
+ * Fixed-point SHT1x conversions against the float versions, for every
+ * raw temperature and humidity value at both resolutions. Checked:
+ * temperature and relative humidity within 0.01, dew point within
+ * 0.05 degrees C. Raw temperatures above the 123.8 degrees C end of the
+ * sensor range are skipped.
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "Arduino.h"
+// The raw values and calculcate() are private.
+#define private public
+#include "SHT1x.h"
+#undef private
+#include "check.h"
+#include <math.h>
+
+
+#define MAX_T_ERROR  0.01
+#define MAX_RH_ERROR  0.01
+#define MAX_DEWPOINT_ERROR  0.05
+#define MAX_TEMPERATURE  123.8
+
+
+static void testResolution(SHT1x& sht11, boolean low)
+{
+  uint16_t t_max = low? 0x0fff : 0x3fff;
+  uint16_t rh_max = low? 0x00ff : 0x0fff;
+  double t_error = 0;
+  double rh_error = 0;
+  double dewpoint_error = 0;
+
+  sht11._status = low? SHT1X_STATUS_LOW_RESOLUTION : 0;
+  for (uint32_t t=0; t<=t_max; t++)
+  {
+    for (uint32_t rh=0; rh<=rh_max; rh++)
+    {
+      sht11._raw_temperature = t;
+      sht11._raw_humidity = rh;
+      sht11.calculcate();
+      if (sht11.get_temperature()>MAX_TEMPERATURE) break;
+      t_error = fmax(t_error,fabs(sht11.get_temperature_centi()/100.0-sht11.get_temperature()));
+      rh_error = fmax(rh_error,fabs(sht11.get_humidity_centi()/100.0-sht11.get_humidity()));
+      dewpoint_error = fmax(dewpoint_error,fabs(sht11.get_dewpoint_centi()/100.0-sht11.get_dewpoint()));
+    }
+  }
+  printf("%s resolution: T %.4f, RH %.4f, dew point %.4f\n",low? "low" : "high",t_error,rh_error,dewpoint_error);
+  CHECK(t_error<=MAX_T_ERROR);
+  CHECK(rh_error<=MAX_RH_ERROR);
+  CHECK(dewpoint_error<=MAX_DEWPOINT_ERROR);
+}
+
+
+int main(void)
+{
+  SHT1x sht11;
+  testResolution(sht11,false);
+  testResolution(sht11,true);
+  return report();
+}
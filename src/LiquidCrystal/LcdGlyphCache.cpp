@@ -0,0 +1,52 @@
+#include "LcdGlyphCache.h"
+
+#include "Arduino.h"
+
+LcdGlyphCache::LcdGlyphCache(LiquidCrystal& lcd, const LcdGlyph *glyphs, uint8_t count)
+  : _lcd(lcd), _glyphs(glyphs), _count(count)
+{
+  reset();
+}
+
+// Forget what is loaded, call it after LiquidCrystal::begin()
+void LcdGlyphCache::reset(void) {
+  for (uint8_t i=0; i<LCD_GLYPH_SLOTS; i++) {
+    _id[i] = LCD_GLYPH_NONE;
+    _order[i] = LCD_GLYPH_SLOTS - 1 - i; // slot 0 gets used first
+  }
+}
+
+// Return the character code showing glyph id, load it if needed
+uint8_t LcdGlyphCache::get(uint8_t id) {
+  if (id >= _count) return ' ';
+
+  for (uint8_t slot=0; slot<LCD_GLYPH_SLOTS; slot++) {
+    if (_id[slot] == id) {
+      use(slot);
+      return slot;
+    }
+  }
+
+  uint8_t slot = _order[LCD_GLYPH_SLOTS - 1];
+  uint8_t evicted = _id[slot];
+  uint8_t bitmap[8];
+  for (uint8_t i=0; i<8; i++) {
+    bitmap[i] = pgm_read_byte(&_glyphs[id].bitmap[i]);
+  }
+  _lcd.createChar(slot, bitmap);
+  // cells that showed the evicted glyph now show the new one, correct them
+  _lcd.replaceChar(slot, evicted == LCD_GLYPH_NONE ? ' ' : pgm_read_byte(&_glyphs[evicted].fallback));
+  _id[slot] = id;
+  use(slot);
+  return slot;
+}
+
+// move slot to the front of the LRU order
+void LcdGlyphCache::use(uint8_t slot) {
+  uint8_t i = 0;
+  while (_order[i] != slot) i++;
+  for (; i>0; i--) {
+    _order[i] = _order[i-1];
+  }
+  _order[0] = slot;
+}
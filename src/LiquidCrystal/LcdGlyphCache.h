@@ -0,0 +1,39 @@
+#ifndef LcdGlyphCache_h
+#define LcdGlyphCache_h
+
+#include <inttypes.h>
+#include "LiquidCrystal.h"
+
+#define LCD_GLYPH_SLOTS 8
+#define LCD_GLYPH_NONE 0xff
+
+// A custom character and the ROM character to show in its place when it
+// is no longer loaded in CGRAM.
+struct LcdGlyph {
+  uint8_t bitmap[8];
+  uint8_t fallback;
+};
+
+// Maps glyph IDs (indices into a PROGMEM table of LcdGlyph) on the 8 CGRAM
+// slots of the display. A glyph is only uploaded when it is not resident;
+// when all slots are taken the least recently used glyph is evicted and
+// the cells still showing it get its fallback character.
+class LcdGlyphCache {
+public:
+  LcdGlyphCache(LiquidCrystal& lcd, const LcdGlyph *glyphs, uint8_t count);
+
+  uint8_t get(uint8_t id);
+  size_t write(uint8_t id) { return _lcd.write(get(id)); }
+  void reset(void);
+
+private:
+  LiquidCrystal& _lcd;
+  const LcdGlyph *_glyphs;
+  uint8_t _count;
+  uint8_t _id[LCD_GLYPH_SLOTS]; // glyph loaded in each slot
+  uint8_t _order[LCD_GLYPH_SLOTS]; // slots, most recently used first
+
+  void use(uint8_t slot);
+};
+
+#endif
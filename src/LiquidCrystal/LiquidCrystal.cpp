@@ -5,6 +5,9 @@
 #include <inttypes.h>
 #include "Arduino.h"
 
+// queue entry flag, the byte goes to the data register
+#define LCD_QUEUE_DATA 0x100
+
 // When the display powers up, it is configured as follows:
 //
 // 1. Display clear
@@ -87,6 +90,20 @@ void LiquidCrystal::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
     _displayfunction |= LCD_2LINE;
   }
   _numlines = lines;
+  _numcols = cols;
+  // the shadow buffer, the queue and busy flag polling are always off
+  // after begin(), the display is initialised with fixed delays
+  _shadow = 0;
+  _shifted = 0;
+  _async = 0;
+  _busyflag = 0;
+  _queue_busy = 0;
+  _queue_head = 0;
+  _queue_tail = 0;
+  _queue_nibble = 0;
+#ifdef __LCD_STATISTICS__
+  resetStatistics();
+#endif /* __LCD_STATISTICS__ */
 
   setRowOffsets(0x00, 0x40, 0x00 + cols, 0x40 + cols);  
 
@@ -175,14 +192,35 @@ void LiquidCrystal::setRowOffsets(int row0, int row1, int row2, int row3)
 /********** high level commands, for the user! */
 void LiquidCrystal::clear()
 {
+  for (uint8_t row=0; row<LCD_SHADOW_ROWS; row++) {
+    for (uint8_t col=0; col<LCD_SHADOW_COLS; col++) {
+      if (_shadow && _frame[row][col] != ' ') {
+        _dirty[row][col>>3] |= 1 << (col&7);
+      }
+      _frame[row][col] = ' ';
+    }
+  }
+  _col = 0;
+  _row = 0;
+  // flush() only sends the cells that were not blank, unless the display
+  // is larger than the shadow buffer or shifted
+  if (_shadow && !_shifted && _numcols <= LCD_SHADOW_COLS && _numlines <= LCD_SHADOW_ROWS) return;
+
+  memset(_dirty, 0, sizeof(_dirty));
+  _shifted = 0;
   command(LCD_CLEARDISPLAY);  // clear display, set cursor position to zero
-  delayMicroseconds(2000);  // this command takes a long time!
+  if (!_async) waitReady(2000);  // this command takes a long time!
 }
 
 void LiquidCrystal::home()
 {
+  _col = 0;
+  _row = 0;
+  if (_shadow && !_shifted) return; // only undo a display shift
+
+  _shifted = 0;
   command(LCD_RETURNHOME);  // set cursor position to zero
-  delayMicroseconds(2000);  // this command takes a long time!
+  if (!_async) waitReady(2000);  // this command takes a long time!
 }
 
 void LiquidCrystal::setCursor(uint8_t col, uint8_t row)
@@ -194,7 +232,11 @@ void LiquidCrystal::setCursor(uint8_t col, uint8_t row)
   if ( row >= _numlines ) {
     row = _numlines - 1;    // we count rows starting w/0
   }
-  
+
+  _col = col;
+  _row = row;
+  if (_shadow) return;
+
   command(LCD_SETDDRAMADDR | (col + _row_offsets[row]));
 }
 
@@ -230,9 +272,11 @@ void LiquidCrystal::blink() {
 
 // These commands scroll the display without changing the RAM
 void LiquidCrystal::scrollDisplayLeft(void) {
+  _shifted = 1;
   command(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
 }
 void LiquidCrystal::scrollDisplayRight(void) {
+  _shifted = 1;
   command(LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
 }
 
@@ -260,14 +304,212 @@ void LiquidCrystal::noAutoscroll(void) {
   command(LCD_ENTRYMODESET | _displaymode);
 }
 
+// Buffer all writes in the shadow buffer until flush() is called.
+// The shadow buffer assumes left to right text without autoscroll.
+void LiquidCrystal::shadowBuffer(void) {
+  _shadow = 1;
+}
+
+// Send what is still buffered and return to writing straight to the display
+void LiquidCrystal::noShadowBuffer(void) {
+  flush();
+  _shadow = 0;
+  setCursor(_col, _row);
+}
+
+// Send the cells of the shadow buffer that changed since the last flush.
+// Every run of changed cells costs one setCursor; runs separated by a
+// single unchanged cell are merged as rewriting it costs the same.
+void LiquidCrystal::flush(void) {
+  if (!_shadow) return;
+
+  uint8_t cols = _numcols < LCD_SHADOW_COLS ? _numcols : LCD_SHADOW_COLS;
+  uint8_t rows = _numlines < LCD_SHADOW_ROWS ? _numlines : LCD_SHADOW_ROWS;
+  for (uint8_t row=0; row<rows; row++) {
+    uint8_t col = 0;
+    while (col < cols) {
+      if ((_dirty[row][col>>3] & (1 << (col&7))) == 0) {
+        col++;
+        continue;
+      }
+      uint8_t last = col;
+      for (uint8_t i=col+1; i<cols && i<=last+2; i++) {
+        if (_dirty[row][i>>3] & (1 << (i&7))) last = i;
+      }
+      command(LCD_SETDDRAMADDR | (col + _row_offsets[row]));
+      for (; col<=last; col++) {
+        send(_frame[row][col], HIGH);
+        _dirty[row][col>>3] &= ~(1 << (col&7));
+      }
+    }
+  }
+}
+
+// Queue commands and data instead of waiting for the display, service()
+// then sends them one nibble at a time.
+void LiquidCrystal::asyncQueue(void) {
+  _queue_wait = 0;
+  _queue_stamp = micros();
+  _async = 1;
+}
+
+// Wait until everything queued has been sent and return to blocking mode
+void LiquidCrystal::noAsyncQueue(void) {
+  if (!_async) return;
+  while (_queue_head != _queue_tail) {
+    service();
+  }
+  // copy the multi-byte timing with interrupts off
+  uint8_t sreg = SREG;
+  cli();
+  unsigned long stamp = _queue_stamp;
+  uint16_t wait = _queue_wait;
+  SREG = sreg;
+  while (micros() - stamp < wait);
+  _async = 0;
+}
+
+// Send the next queued nibble if the display had enough time to execute
+// the previous one. Call it often from loop() or from a timer interrupt,
+// it never blocks.
+void LiquidCrystal::service(void) {
+  // test and set atomically, a timer interrupt may call service() too
+  uint8_t sreg = SREG;
+  cli();
+  if (_queue_busy || _queue_head == _queue_tail) {
+    SREG = sreg;
+    return;
+  }
+  _queue_busy = 1;
+  SREG = sreg;
+
+  if (micros() - _queue_stamp < _queue_wait) {
+    // with the busy flag the display may tell it is ready earlier
+    if (!_busyflag || readBusyFlag()) {
+      _queue_busy = 0;
+      return;
+    }
+  }
+
+  uint16_t entry = _queue[_queue_tail];
+  uint8_t done = 1;
+  writeRs((entry & LCD_QUEUE_DATA) ? HIGH : LOW);
+  if (_displayfunction & LCD_8BITMODE) {
+    write8bits(entry);
+  } else if (!_queue_nibble) {
+    write4bits(entry >> 4);
+    done = 0;
+  } else {
+    write4bits(entry);
+  }
+  _queue_stamp = micros();
+
+  _queue_nibble = !done;
+#ifdef __LCD_STATISTICS__
+  if (done) count(entry, (entry & LCD_QUEUE_DATA) ? HIGH : LOW);
+#endif /* __LCD_STATISTICS__ */
+  if (done) {
+    // clear and home take a long time, other commands need > 37us
+    _queue_wait = (entry & ~0x03) == 0 ? 2000 : 100;
+    _queue_tail = (_queue_tail + 1) & (LCD_QUEUE_SIZE - 1);
+  } else {
+    _queue_wait = 0; // the low nibble may follow right away
+  }
+  _queue_busy = 0;
+}
+
+// Poll the busy flag instead of waiting the worst-case execution time of
+// every instruction. Needs the RW pin, without it this does nothing.
+void LiquidCrystal::busyFlag(void) {
+  if (_rw_pin != 255) { 
+    _busyflag = 1;
+  }
+}
+
+// Wait the worst-case execution time again
+void LiquidCrystal::noBusyFlag(void) {
+  _busyflag = 0;
+}
+
 // Allows us to fill the first 8 CGRAM locations
 // with custom characters
 void LiquidCrystal::createChar(uint8_t location, uint8_t charmap[]) {
   location &= 0x7; // we only have 8 locations 0-7
   command(LCD_SETCGRAMADDR | (location << 3));
   for (int i=0; i<8; i++) {
-    write(charmap[i]);
+    send(charmap[i], HIGH); // not write(), CGRAM data must bypass the shadow buffer
+  }
+}
+
+// Rewrite all cells showing character from with character to, for
+// instance after the CGRAM glyph of from was replaced. The cursor
+// position is restored, also when createChar() moved it to CGRAM.
+void LiquidCrystal::replaceChar(uint8_t from, uint8_t to) {
+  uint8_t col = _col;
+  uint8_t row = _row;
+  uint8_t cols = _numcols < LCD_SHADOW_COLS ? _numcols : LCD_SHADOW_COLS;
+  uint8_t rows = _numlines < LCD_SHADOW_ROWS ? _numlines : LCD_SHADOW_ROWS;
+  for (uint8_t r=0; r<rows; r++) {
+    for (uint8_t c=0; c<cols; c++) {
+      if (_frame[r][c] == from) {
+        setCursor(c, r);
+        write(to);
+      }
+    }
+  }
+  setCursor(col, row);
+}
+
+// Print value/10^scale right justified in a field of width characters
+// with the given number of decimals, rounded half away from zero. Values
+// that do not fit are clamped to the largest value that does. The suffix
+// is printed after the field. No floats, no heap.
+size_t LiquidCrystal::printFixed(int32_t value, uint8_t scale, uint8_t width, uint8_t decimals, const char *suffix) {
+  char buf[12]; // sign and 10 digits of an int32_t
+  if (decimals > 9) decimals = 9;
+  uint8_t neg = value < 0;
+  uint32_t mag = neg ? -(uint32_t)value : value;
+
+  // bring the value to the requested number of decimals
+  for (; scale > decimals; scale--) {
+    mag = (mag + (scale - 1 == decimals ? 5 : 0)) / 10;
   }
+  for (; scale < decimals; scale++) {
+    mag = mag < 429496729 ? mag * 10 : 4294967295;
+  }
+  if (mag == 0) neg = 0;
+
+  // clamp to the digits that fit
+  int8_t digits = width - neg - (decimals ? 1 : 0);
+  uint32_t limit = 0;
+  for (int8_t i = 0; i < digits; i++) {
+    if (limit >= 429496729) {
+      limit = 4294967295;
+      break;
+    }
+    limit = limit * 10 + 9;
+  }
+  if (digits <= decimals) {
+    // not even a single integer digit fits
+    for (uint8_t i = 0; i < width; i++) write('#');
+    return width + (suffix ? print(suffix) : 0);
+  }
+  if (mag > limit) mag = limit;
+
+  // render from the right
+  uint8_t n = 0;
+  do {
+    if (n == decimals && decimals) buf[n++] = '.';
+    buf[n++] = '0' + mag % 10;
+    mag /= 10;
+  } while (mag || n <= decimals);
+  if (neg) buf[n++] = '-';
+
+  size_t count = 0;
+  for (uint8_t i = n; i < width; i++) count += write(' ');
+  while (n) count += write(buf[--n]);
+  if (suffix) count += print(suffix);
+  return count;
 }
 
 /*********** mid level commands, for sending data/cmds */
@@ -276,8 +518,24 @@ inline void LiquidCrystal::command(uint8_t value) {
   send(value, LOW);
 }
 
-inline size_t LiquidCrystal::write(uint8_t value) {
+size_t LiquidCrystal::write(uint8_t value) {
+  if (_row < LCD_SHADOW_ROWS && _col < LCD_SHADOW_COLS) {
+    uint8_t *cell = &_frame[_row][_col];
+    if (_shadow) {
+      if (*cell != value) {
+        *cell = value;
+        _dirty[_row][_col>>3] |= 1 << (_col&7);
+      }
+      _col++;
+      return 1;
+    }
+    *cell = value; // keep the mirror in sync with the display
+  } else if (_shadow) {
+    // outside the shadow buffer, write through
+    command(LCD_SETDDRAMADDR | (_col + _row_offsets[_row]));
+  }
   send(value, HIGH);
+  _col++;
   return 1; // assume sucess
 }
 
@@ -285,12 +543,12 @@ inline size_t LiquidCrystal::write(uint8_t value) {
 
 // write either command or data, with automatic 4/8-bit selection
 void LiquidCrystal::send(uint8_t value, uint8_t mode) {
-  digitalWrite(_rs_pin, mode);
-
-  // if there is a RW pin indicated, set it low to Write
-  if (_rw_pin != 255) { 
-    digitalWrite(_rw_pin, LOW);
+  if (_async) {
+    enqueue(mode == HIGH ? value | LCD_QUEUE_DATA : value);
+    return;
   }
+
+  writeRs(mode);
   
   if (_displayfunction & LCD_8BITMODE) {
     write8bits(value); 
@@ -298,6 +556,83 @@ void LiquidCrystal::send(uint8_t value, uint8_t mode) {
     write4bits(value>>4);
     write4bits(value);
   }
+
+  if (_busyflag) waitReady(100);
+#ifdef __LCD_STATISTICS__
+  count(value, mode);
+#endif /* __LCD_STATISTICS__ */
+}
+
+#ifdef __LCD_STATISTICS__
+void LiquidCrystal::resetStatistics(void) {
+  memset(&_statistics, 0, sizeof(_statistics));
+}
+
+// account for a byte written to the display
+void LiquidCrystal::count(uint8_t value, uint8_t mode) {
+  if (mode == HIGH) {
+    _statistics.data++;
+  } else {
+    _statistics.commands++;
+  }
+  _statistics.pulses += (_displayfunction & LCD_8BITMODE) ? 1 : 2;
+  // clear and home take 1.52 ms, everything else 37 us
+  _statistics.bus_us += (mode == LOW && value <= 0x03 && value != 0) ? 1520 : 37;
+}
+#endif /* __LCD_STATISTICS__ */
+
+// read the busy flag (DB7) once, RW must be connected
+uint8_t LiquidCrystal::readBusyFlag(void) {
+  uint8_t n = (_displayfunction & LCD_8BITMODE) ? 8 : 4;
+  for (uint8_t i = 0; i < n; i++) {
+    pinMode(_data_pins[i], INPUT);
+  }
+  digitalWrite(_rs_pin, LOW);
+  digitalWrite(_rw_pin, HIGH);
+  digitalWrite(_enable_pin, HIGH);
+  delayMicroseconds(1);    // data is valid 360ns after enable went high
+  uint8_t busy = digitalRead(_data_pins[n - 1]);
+  digitalWrite(_enable_pin, LOW);
+  if (n == 4) {
+    // clock out the low nibble (address counter) as well
+    delayMicroseconds(1);
+    digitalWrite(_enable_pin, HIGH);
+    delayMicroseconds(1);
+    digitalWrite(_enable_pin, LOW);
+  }
+  digitalWrite(_rw_pin, LOW);
+  return busy;
+}
+
+// wait until the display finished the last instruction, but never longer
+// than the given worst-case execution time
+void LiquidCrystal::waitReady(uint16_t timeout) {
+  if (!_busyflag) {
+    delayMicroseconds(timeout);
+    return;
+  }
+  unsigned long start = micros();
+  while (readBusyFlag() && micros() - start < timeout);
+}
+
+// queue an entry, wait for room if the queue is full
+void LiquidCrystal::enqueue(uint16_t entry) {
+  uint8_t head = (_queue_head + 1) & (LCD_QUEUE_SIZE - 1);
+  while (head == _queue_tail) {
+    service();
+  }
+  _queue[_queue_head] = entry;
+  _queue_head = head;
+}
+
+// select the command (LOW) or data (HIGH) register for writing
+void LiquidCrystal::writeRs(uint8_t mode) {
+  digitalWrite(_rs_pin, mode);
+
+  // if there is a RW pin indicated, set it low to Write
+  if (_rw_pin != 255) { 
+    digitalWrite(_rw_pin, LOW);
+  }
 }
 
 void LiquidCrystal::pulseEnable(void) {
@@ -306,7 +641,12 @@ void LiquidCrystal::pulseEnable(void) {
   digitalWrite(_enable_pin, HIGH);
   delayMicroseconds(1);    // enable pulse must be >450ns
   digitalWrite(_enable_pin, LOW);
-  delayMicroseconds(100);   // commands need > 37us to settle
+  settle();
+}
+
+void LiquidCrystal::settle(void) {
+  // commands need > 37us to settle, unless we poll the busy flag or service() spaces them
+  if (!_async && !_busyflag) delayMicroseconds(100);
 }
 
 void LiquidCrystal::write4bits(uint8_t value) {
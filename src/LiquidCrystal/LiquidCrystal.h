@@ -4,6 +4,10 @@
 #include <inttypes.h>
 #include "Print.h"
 
+// Count the bytes sent to the display and the time the HD44780 needs to
+// execute them, see the LcdBenchmark example.
+//#define __LCD_STATISTICS__
+
 // commands
 #define LCD_CLEARDISPLAY 0x01
 #define LCD_RETURNHOME 0x02
@@ -42,6 +46,28 @@
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS 0x00
 
+// shadow buffer size, enough for the 16x2 display of the shield
+#ifndef LCD_SHADOW_COLS
+#define LCD_SHADOW_COLS 16
+#endif
+#ifndef LCD_SHADOW_ROWS
+#define LCD_SHADOW_ROWS 2
+#endif
+
+// queue size of the asynchronous mode, must be a power of 2
+#ifndef LCD_QUEUE_SIZE
+#define LCD_QUEUE_SIZE 32
+#endif
+
+#ifdef __LCD_STATISTICS__
+struct LcdStatistics {
+  uint32_t commands; // instruction register writes
+  uint32_t data; // data register writes
+  uint32_t pulses; // enable pulses
+  uint32_t bus_us; // HD44780 execution time at 270 kHz
+};
+#endif /* __LCD_STATISTICS__ */
+
 class LiquidCrystal : public Print {
 public:
   LiquidCrystal(void) {}  // CPV
@@ -77,19 +103,41 @@ public:
   void rightToLeft();
   void autoscroll();
   void noAutoscroll();
+  void shadowBuffer();
+  void noShadowBuffer();
+  void asyncQueue();
+  void noAsyncQueue();
+  void service();
+  void busyFlag();
+  void noBusyFlag();
 
   void setRowOffsets(int row1, int row2, int row3, int row4);
   void createChar(uint8_t, uint8_t[]);
+  void replaceChar(uint8_t, uint8_t);
+  size_t printFixed(int32_t value, uint8_t scale, uint8_t width, uint8_t decimals = 0, const char *suffix = 0);
+  size_t printField(int32_t value, uint8_t width, const char *suffix = 0) { return printFixed(value, 0, width, 0, suffix); }
   void setCursor(uint8_t, uint8_t); 
   virtual size_t write(uint8_t);
   void command(uint8_t);
+  virtual void flush();
+#ifdef __LCD_STATISTICS__
+  const LcdStatistics& statistics() const { return _statistics; }
+  void resetStatistics();
+#endif /* __LCD_STATISTICS__ */
   
   using Print::write;
+protected:
+  // pin level hooks, LiquidCrystalFast replaces them by direct port access
+  virtual void writeRs(uint8_t);
+  virtual void write4bits(uint8_t);
+  void settle();
 private:
   void send(uint8_t, uint8_t);
-  void write4bits(uint8_t);
   void write8bits(uint8_t);
   void pulseEnable();
+  void enqueue(uint16_t);
+  uint8_t readBusyFlag();
+  void waitReady(uint16_t);
 
   uint8_t _rs_pin; // LOW: command.  HIGH: character.
   uint8_t _rw_pin; // LOW: write to LCD.  HIGH: read from LCD.
@@ -101,9 +149,36 @@ private:
   uint8_t _displaymode;
 
   uint8_t _initialized;
+  uint8_t _busyflag; // poll the busy flag instead of fixed delays
 
   uint8_t _numlines;
+  uint8_t _numcols;
   uint8_t _row_offsets[4];
+
+  // Mirror of the display contents, plus one dirty bit per cell that
+  // still has to be sent by flush() when the shadow buffer is enabled.
+  uint8_t _shadow;
+  uint8_t _shifted; // scrolled since the last clear or home
+  uint8_t _col;
+  uint8_t _row;
+  uint8_t _frame[LCD_SHADOW_ROWS][LCD_SHADOW_COLS];
+  uint8_t _dirty[LCD_SHADOW_ROWS][(LCD_SHADOW_COLS+7)/8];
+
+  // Bytes waiting to be sent by service() in asynchronous mode. Only
+  // the owner of _queue_busy touches the tail entry and its timing.
+  uint8_t _async;
+  volatile uint8_t _queue_busy;
+  volatile uint8_t _queue_head;
+  volatile uint8_t _queue_tail;
+  volatile uint8_t _queue_nibble; // the high nibble of the tail entry was sent
+  volatile uint16_t _queue_wait; // microseconds to wait before the next nibble
+  volatile unsigned long _queue_stamp; // time the last nibble was sent
+  volatile uint16_t _queue[LCD_QUEUE_SIZE];
+
+#ifdef __LCD_STATISTICS__
+  LcdStatistics _statistics;
+  void count(uint8_t, uint8_t);
+#endif /* __LCD_STATISTICS__ */
 };
 
 #endif
@@ -0,0 +1,69 @@
+#ifndef LiquidCrystalFast_h
+#define LiquidCrystalFast_h
+
+#include <inttypes.h>
+#include "Arduino.h"
+#include "LiquidCrystal.h"
+
+// A pin known at compile time. On the ATmega328 (Uno) the pin number
+// fixes the port and bit, so every access compiles to a single sbi/cbi.
+// Other boards fall back on pinMode()/digitalWrite().
+template <uint8_t pin>
+struct LcdFastPin {
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega8__)
+  static inline void output() {
+    if (pin < 8) DDRD |= _BV(pin & 7);
+    else if (pin < 14) DDRB |= _BV((pin - 8) & 7);
+    else DDRC |= _BV((pin - 14) & 7);
+  }
+  static inline void write(uint8_t value) {
+    if (pin < 8) {
+      if (value) PORTD |= _BV(pin & 7);
+      else PORTD &= ~_BV(pin & 7);
+    } else if (pin < 14) {
+      if (value) PORTB |= _BV((pin - 8) & 7);
+      else PORTB &= ~_BV((pin - 8) & 7);
+    } else {
+      if (value) PORTC |= _BV((pin - 14) & 7);
+      else PORTC &= ~_BV((pin - 14) & 7);
+    }
+  }
+#else
+  static inline void output() { pinMode(pin, OUTPUT); }
+  static inline void write(uint8_t value) { digitalWrite(pin, value); }
+#endif
+};
+
+// LiquidCrystal for a fixed 4-bit pinout with RW tied low. The nibble and
+// register select writes skip the pin table lookups of digitalWrite().
+template <uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7>
+class LiquidCrystalFast : public LiquidCrystal {
+public:
+  LiquidCrystalFast(void) {}
+
+  using LiquidCrystal::init;
+  void init(void) { init(1, rs, 255, enable, d4, d5, d6, d7, 0, 0, 0, 0); }
+
+protected:
+  virtual void writeRs(uint8_t mode) {
+    LcdFastPin<rs>::write(mode);
+  }
+
+  virtual void write4bits(uint8_t value) {
+    LcdFastPin<d4>::output();
+    LcdFastPin<d5>::output();
+    LcdFastPin<d6>::output();
+    LcdFastPin<d7>::output();
+    LcdFastPin<d4>::write(value & 0x01);
+    LcdFastPin<d5>::write(value & 0x02);
+    LcdFastPin<d6>::write(value & 0x04);
+    LcdFastPin<d7>::write(value & 0x08);
+
+    LcdFastPin<enable>::write(HIGH);
+    delayMicroseconds(1);    // enable pulse must be >450ns
+    LcdFastPin<enable>::write(LOW);
+    settle();
+  }
+};
+
+#endif
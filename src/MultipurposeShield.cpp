@@ -34,6 +34,11 @@
 MultipurposeShield::MultipurposeShield(uint32_t peripherals)
 {
   _peripherals = peripherals;
+  _infrared = 0;
+  _infraredStatus = statusOk;
+  _taskCount = 0;
+  _scheduled = 0;
+  _slice = MPS_SLICE;
 }
 
 
@@ -148,12 +153,22 @@ void MultipurposeShield::begin(void)
 
 
 float MultipurposeShield::thermometerRead(void)
+{
+  int16_t value;
+  if (thermometerReadCenti(value)!=statusOk) return FLT_MAX;
+  return value/100.0;
+}
+
+
+uint8_t MultipurposeShield::thermometerReadCenti(int16_t& value)
 {
   if (multipurposeShield(hasThermometer))
   {
-    return ds18b20.read();
+    if ((_scheduled&hasThermometer)!=0) return _thermometer.cached(value);
+    return _thermometer.read(ds18b20,value);
   }
-  return FLT_MAX;
+  value = 0;
+  return statusNotFitted;
 }
 
 
@@ -172,9 +187,21 @@ boolean MultipurposeShield::humiditySensorRead(void)
 {
   if (multipurposeShield(hasHumiditySensor))
   {
-    sht11.begin(SDA,SCL,true);
-    sht11.update();
-    return true;
+    // A scheduled read of the infrared thermometer may be using A4/A5.
+    if ((_scheduled&hasHumiditySensor)!=0 || taskBusy(hasIrThermometer)==true) return _humidity.valid();
+    return _humidity.read(sht11,_bus);
+  }
+  return false;
+}
+
+
+boolean MultipurposeShield::humiditySensorRefresh(void)
+{
+  if (multipurposeShield(hasHumiditySensor))
+  {
+    // The scheduler keeps the snapshot fresh.
+    if ((_scheduled&hasHumiditySensor)!=0 || taskBusy(hasIrThermometer)==true) return humiditySensorRead();
+    return _humidity.refresh(sht11,_bus);
   }
   return false;
 }
@@ -184,7 +211,7 @@ float MultipurposeShield::humiditySensorReadRh(void)
 {
   if (humiditySensorRead()==true)
   {
-    return sht11.get_humidity();
+    return _humidity.rh();
   }
   return FLT_MAX;
 }
@@ -194,7 +221,7 @@ float MultipurposeShield::humiditySensorReadT(void)
 {
   if (humiditySensorRead()==true)
   {
-    return sht11.get_temperature();
+    return _humidity.t();
   }
   return FLT_MAX;
 }
@@ -204,20 +231,67 @@ float MultipurposeShield::humiditySensorReadDewPoint(void)
 {
   if (humiditySensorRead()==true)
   {
-    return sht11.get_dewpoint();
+    return _humidity.dewPoint();
   }
   return FLT_MAX;
 }
 
 
+uint8_t MultipurposeShield::humiditySensorReadTCenti(int16_t& value)
+{
+  value = 0;
+  if (multipurposeShield(hasHumiditySensor))
+  {
+    if (humiditySensorRead()==false) return statusSensorError;
+    value = _humidity.tCenti();
+    return statusOk;
+  }
+  return statusNotFitted;
+}
+
+
+uint8_t MultipurposeShield::humiditySensorReadDewPointCenti(int16_t& value)
+{
+  value = 0;
+  if (multipurposeShield(hasHumiditySensor))
+  {
+    if (humiditySensorRead()==false) return statusSensorError;
+    value = _humidity.dewPointCenti();
+    return statusOk;
+  }
+  return statusNotFitted;
+}
+
+
 float MultipurposeShield::infraredThermometerRead(void)
 {
+  int16_t value;
+  if (infraredThermometerReadCenti(value)!=statusOk) return FLT_MAX;
+  return value/100.0;
+}
+
+
+uint8_t MultipurposeShield::infraredThermometerReadCenti(int16_t& value)
+{
+  value = 0;
   if (multipurposeShield(hasIrThermometer))
   {
-    mlx90614.begin(A4,A5);
-    return mlx90614.read();
+    if ((_scheduled&hasIrThermometer)!=0)
+    {
+      value = _infrared;
+      return _infraredStatus;
+    }
+    if (taskBusy(hasHumiditySensor)==true)
+    {
+      value = _infrared;
+      return statusBusy;
+    }
+    _bus.selectTwi(mlx90614);
+    _infraredStatus = mlx90614.readCenti(_infrared)==MLX90614_OK? statusOk : statusSensorError;
+    value = _infrared;
+    return _infraredStatus;
   }
-  return FLT_MAX;
+  return statusNotFitted;
 }
 
 
@@ -238,6 +312,261 @@ int16_t MultipurposeShield::lightSensorRead(boolean asPercentage)
 }
 
 
+int8_t MultipurposeShield::schedule(uint32_t peripheral, uint32_t period, mpsCallback callback)
+{
+  if (_taskCount>=MPS_TASKS_MAX || period==0) return -1;
+  if ((_peripherals&peripheral)!=peripheral || (_scheduled&peripheral)!=0) return -1;
+  // taskStep() samples one sensor per task, a sensor mixed with other
+  // bits would never be sampled.
+  if ((peripheral&(hasThermometer|hasHumiditySensor|hasIrThermometer))!=0 &&
+      peripheral!=hasThermometer && peripheral!=hasHumiditySensor && peripheral!=hasIrThermometer) return -1;
+  MpsTask& task = _tasks[_taskCount];
+  task.peripheral = peripheral;
+  task.period = period;
+  task.release = millis();
+  task.deadline = task.release;
+  task.start = task.release;
+  task.callback = callback;
+  task.phase = 0;
+  task.missed = 0;
+  _scheduled |= peripheral;
+  // No sample until the first job is done.
+  if (peripheral==hasHumiditySensor) _humidity.invalidate();
+  if (peripheral==hasThermometer) _thermometer.set(0,statusBusy);
+  if (peripheral==hasIrThermometer) _infraredStatus = statusBusy;
+  return _taskCount++;
+}
+
+
+void MultipurposeShield::run(void)
+{
+  uint32_t start = micros();
+  uint8_t stepped = 0; // every task gets one step per run
+  do
+  {
+    uint32_t now = millis();
+    MpsTask *next = 0;
+    uint32_t deadline = 0;
+    uint8_t n = 0;
+    for (uint8_t i=0; i<_taskCount; i++)
+    {
+      MpsTask& task = _tasks[i];
+      uint32_t d = task.deadline;
+      if ((stepped&(1<<i))!=0) continue;
+      if (task.phase==0)
+      {
+        if ((int32_t)(now-task.release)<0) continue;
+        // The humidity sensor and the infrared thermometer share A4/A5,
+        // a job must wait for one of the other to finish.
+        if (task.peripheral==hasIrThermometer && taskBusy(hasHumiditySensor)==true) continue;
+        if (task.peripheral==hasHumiditySensor && taskBusy(hasIrThermometer)==true) continue;
+        d = task.release + task.period;
+      }
+      if (next==0 || (int32_t)(d-deadline)<0)
+      {
+        next = &task;
+        deadline = d;
+        n = i;
+      }
+    }
+    if (next==0) break;
+    stepped |= 1<<n;
+
+    if (next->phase==0)
+    {
+      // Release a new job.
+      next->deadline = next->release + next->period;
+      next->release = next->deadline;
+      next->phase = 1;
+      next->start = now;
+    }
+    if (taskStep(*next)==true)
+    {
+      next->phase = 0;
+      now = millis();
+      if ((int32_t)(now-next->deadline)>0)
+      {
+        // Skip the releases that passed, no burst to catch up.
+        next->missed++;
+        next->release = now;
+      }
+      if (next->callback!=0) next->callback();
+    }
+  }
+  while (micros()-start<_slice);
+}
+
+
+// A job of the task sampling this peripheral is running.
+boolean MultipurposeShield::taskBusy(uint32_t peripheral)
+{
+  for (uint8_t i=0; i<_taskCount; i++)
+  {
+    if (_tasks[i].peripheral==peripheral && _tasks[i].phase!=0) return true;
+  }
+  return false;
+}
+
+
+// Runs one step of the job of a task, returns true when it is done.
+boolean MultipurposeShield::taskStep(MpsTask& task)
+{
+  switch (task.peripheral)
+  {
+    case hasThermometer:
+      if (task.phase==1)
+      {
+        task.phase = 2;
+        if (ds18b20.startConversion()==true) return false;
+      }
+      else if (ds18b20.isReady()==true)
+      {
+        int16_t value;
+        uint8_t status = ds18b20.readResultCenti(value)==DS1820_OK? statusOk : statusSensorError;
+        _thermometer.set(value,status);
+        return true;
+      }
+      else if (millis()-task.start<=2*ds18b20.conversionTime()) return false;
+      _thermometer.set(0,statusSensorError);
+      return true;
+
+    case hasHumiditySensor:
+      if (task.phase==1)
+      {
+        _bus.selectSht(sht11);
+        task.phase = 2;
+        if (sht11.start_temperature()==false) return false;
+      }
+      else if (sht11.poll()==false) return false;
+      else if (sht11.result_error()==false)
+      {
+        if (task.phase==2)
+        {
+          task.phase = 3;
+          if (sht11.start_humidity()==false) return false;
+        }
+        else
+        {
+          _humidity.sample(sht11);
+          return true;
+        }
+      }
+      _humidity.invalidate();
+      return true;
+
+    case hasIrThermometer:
+#ifdef __MLX90614_ASYNC_TWI__
+      // Queue the read, then poll it until the interrupt is done.
+      if (task.phase==1)
+      {
+        _bus.selectTwi(mlx90614);
+        _infraredTransfer.command = MLX90614_READ_TEMPERATURE;
+        _infraredTransfer.write = false;
+        if (mlx90614.submit(_infraredTransfer)==false) task.phase = 2;
+        return false;
+      }
+      else if (_infraredTransfer.status==MLX90614_BUSY) return false;
+      else
+      {
+        uint8_t status = _infraredTransfer.status;
+        if (status==MLX90614_OK) status = MLX90614::convertCenti(_infraredTransfer.value,_infrared);
+        else _infrared = 0;
+        _infraredStatus = status==MLX90614_OK? statusOk : statusSensorError;
+        return true;
+      }
+#else
+      _bus.selectTwi(mlx90614);
+      _infraredStatus = mlx90614.readCenti(_infrared)==MLX90614_OK? statusOk : statusSensorError;
+      return true;
+#endif /* __MLX90614_ASYNC_TWI__ */
+
+    default:
+      return true;
+  }
+}
+
+
+void MpsBus::selectSht(SHT1x& sht11)
+{
+  if (_mode==busSht) return;
+  if (_sht11Started==false)
+  {
+    sht11.begin(SDA,SCL,true);
+    _sht11Started = true;
+  }
+  else
+  {
+    // The sensor may have seen TWI traffic as garbage.
+    sht11.disable_twi();
+    sht11.connection_reset();
+  }
+  _mode = busSht;
+}
+
+
+void MpsBus::selectTwi(MLX90614& mlx90614)
+{
+  if (_mode==busTwi) return;
+  // Enables TWI again.
+  mlx90614.begin(A4,A5);
+  _mode = busTwi;
+}
+
+
+uint8_t MpsThermometer::read(DS1820& ds18b20, int16_t& value)
+{
+  uint8_t status;
+  if (_converting==false)
+  {
+    status = ds18b20.readCenti(_value);
+  }
+  else if (ds18b20.isReady()==true)
+  {
+    status = ds18b20.readResultCenti(_value);
+  }
+  else
+  {
+    // Still converting.
+    value = _value;
+    return _status;
+  }
+  _status = status==DS1820_OK? statusOk : statusSensorError;
+  _converting = ds18b20.startConversion();
+  value = _value;
+  return _status;
+}
+
+
+boolean MpsHumidity::read(SHT1x& sht11, MpsBus& bus)
+{
+  if (_valid==false || millis()-_timestamp>_maxAge)
+  {
+    return refresh(sht11,bus);
+  }
+  return true;
+}
+
+
+boolean MpsHumidity::refresh(SHT1x& sht11, MpsBus& bus)
+{
+  bus.selectSht(sht11);
+  if (sht11.update()==true) return false;
+  sample(sht11);
+  return true;
+}
+
+
+void MpsHumidity::sample(SHT1x& sht11)
+{
+  _t = sht11.get_temperature();
+  _rh = sht11.get_humidity();
+  _tCenti = sht11.get_temperature_centi();
+  _dewPointCenti = sht11.get_dewpoint_centi();
+  _timestamp = millis();
+  _valid = true;
+}
+
+
 void MultipurposeShield::digitalWriteChecked(uint32_t hasPeripheral, uint8_t pin, uint8_t value)
 {
   if (multipurposeShield(hasPeripheral))
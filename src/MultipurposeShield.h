@@ -25,7 +25,6 @@
  */
 
 //#define __CELSIUS__
-//#define __USE_CRC__
 
 #ifndef __MULTIPURPOSESHIELD_H__
 #define __MULTIPURPOSESHIELD_H__
@@ -33,11 +32,21 @@
 
 #include <float.h>
 #include "LiquidCrystal\LiquidCrystal.h"
+#include "LiquidCrystal\LiquidCrystalFast.h"
+#include "LiquidCrystal\LcdGlyphCache.h"
 #include "sht1x\sht1x.h"
 #include "mlx90614\mlx90614.h"
 #include "ds1820\ds1820.h"
 
 
+// Humidity sensor readings younger than this are reused.
+#define MPS_HUMIDITY_MAX_AGE  500 /* ms */
+
+// Scheduler.
+#define MPS_TASKS_MAX  4 /* 8 at most */
+#define MPS_SLICE  2000 /* us */
+
+
 
 enum multipurposeShieldPeripherals
 {
@@ -68,6 +77,16 @@ enum multipurposeShieldPeripherals
 };
 
 
+// Status codes of the integer sensor functions.
+enum multipurposeShieldStatus
+{
+  statusOk = 0,
+  statusNotFitted,
+  statusSensorError,
+  statusBusy, // A4/A5 are in use, or a scheduled sensor has no sample yet
+};
+
+
 enum multipurposeShieldPeripheralPins
 {
   // Digital IO.
@@ -101,6 +120,93 @@ enum multipurposeShieldPeripheralPins
 };
 
 
+typedef void (*mpsCallback)(void);
+
+struct MpsTask
+{
+  uint32_t peripheral;
+  uint32_t period; // ms
+  uint32_t release; // start of the next job
+  uint32_t deadline; // end of the current job
+  uint32_t start; // of the current job
+  mpsCallback callback;
+  uint8_t phase; // 0 when waiting for the release
+  uint16_t missed;
+};
+
+
+// Parts shared by MultipurposeShield and MultipurposeShieldFixed, they
+// work on the drivers of the shield object.
+
+// The humidity sensor and the infrared thermometer share A4/A5, the
+// pins are switched between bit-banging and TWI only when needed.
+class MpsBus
+{
+public:
+  MpsBus(void) : _mode(busNone), _sht11Started(false) {}
+  void selectSht(SHT1x& sht11);
+  void selectTwi(MLX90614& mlx90614);
+  // A4/A5 were used outside the shield.
+  void changed(void) { _mode = busNone; }
+
+private:
+  enum { busNone, busSht, busTwi };
+
+  uint8_t _mode;
+  boolean _sht11Started;
+};
+
+
+// DS18B20 conversions are pipelined, only the first read waits for one.
+// After that the result of the last finished conversion is returned at
+// once and the next conversion is started.
+class MpsThermometer
+{
+public:
+  MpsThermometer(void) : _value(0), _status(statusOk), _converting(false) {}
+  uint8_t read(DS1820& ds18b20, int16_t& value);
+  uint8_t cached(int16_t& value) { value = _value; return _status; }
+  void set(int16_t value, uint8_t status) { _value = value; _status = status; }
+
+private:
+  int16_t _value; // centi-degrees
+  uint8_t _status;
+  boolean _converting;
+};
+
+
+// One snapshot of T and RH shared by the humidity getters, it is only
+// refreshed when it is older than the maximum age. It is a copy, so a
+// measurement in progress does not change it.
+class MpsHumidity
+{
+public:
+  MpsHumidity(void) : _maxAge(MPS_HUMIDITY_MAX_AGE), _timestamp(0), _valid(false) {}
+  boolean read(SHT1x& sht11, MpsBus& bus);
+  boolean refresh(SHT1x& sht11, MpsBus& bus);
+  void maxAge(uint32_t ms) { _maxAge = ms; }
+  boolean valid(void) { return _valid; }
+  // End of a measurement made elsewhere.
+  void sample(SHT1x& sht11);
+  void invalidate(void) { _valid = false; }
+
+  float t(void) { return _t; }
+  float rh(void) { return _rh; }
+  float dewPoint(void) { return SHT1x::calculate_dewpoint(_t,_rh); }
+  int16_t tCenti(void) { return _tCenti; }
+  int16_t dewPointCenti(void) { return _dewPointCenti; }
+
+private:
+  uint32_t _maxAge;
+  uint32_t _timestamp;
+  boolean _valid;
+  float _t;
+  float _rh;
+  int16_t _tCenti;
+  int16_t _dewPointCenti;
+};
+
+
 class MultipurposeShield
 {
 public:
@@ -109,23 +215,59 @@ public:
   void begin(void);
 
   // One-wire thermometer IC2 DS18B20.
+  // Conversions are pipelined, only the first call waits for one. After
+  // that the result of the last finished conversion is returned at once
+  // and the next conversion is started. thermometerRead() returns FLT_MAX
+  // when there is no valid result.
   float thermometerRead(void);
+  uint8_t thermometerReadCenti(int16_t& value);
 
   // Pressure sensor IC3 MPX4115.
   int16_t pressureSensorRead(int16_t offset=0);
 
   // Humidity sensor IC4 SHT11.
+  // The getters share one snapshot of T and RH, it is only refreshed
+  // when it is older than the maximum age.
   boolean humiditySensorRead(void);
+  boolean humiditySensorRefresh(void);
+  void humiditySensorMaxAge(uint32_t ms) { _humidity.maxAge(ms); }
   float humiditySensorReadRh(void);
   float humiditySensorReadT(void);
   float humiditySensorReadDewPoint(void);
+  uint8_t humiditySensorReadTCenti(int16_t& value);
+  uint8_t humiditySensorReadDewPointCenti(int16_t& value);
 
-  // Infrared thermometer IC5 MLX90614.
+  // The humidity sensor and the infrared thermometer share A4/A5, the
+  // shield switches between bit-banging and TWI only when needed. Call
+  // busChanged() after using these pins outside the shield.
+  void busChanged(void) { _bus.changed(); }
+
+  // Infrared thermometer IC5 MLX90614. infraredThermometerRead() returns
+  // FLT_MAX when there is no valid result.
   float infraredThermometerRead(void);
+  uint8_t infraredThermometerReadCenti(int16_t& value);
 
   // Light sensor LDR1.
   int16_t lightSensorRead(boolean asPercentage=true);
 
+  // Cooperative scheduler. schedule() samples a sensor every period ms
+  // and calls the callback when the sample is ready, the getters then
+  // return the sample without touching the sensor. The thermometer, the
+  // humidity sensor and the infrared thermometer are sampled step by step
+  // without blocking, each in a task of its own. Other peripherals, or
+  // 0, just get the callback. While a humidity job runs the humidity
+  // getters return the last complete sample and the infrared thermometer
+  // statusBusy. Returns the task number or -1.
+  int8_t schedule(uint32_t peripheral, uint32_t period, mpsCallback callback);
+  // Runs the due steps, earliest deadline first, for about a slice. A
+  // single step can take longer, reading a DS18B20 takes up to 5 ms.
+  // Without __MLX90614_ASYNC_TWI__ the infrared thermometer step blocks
+  // for a whole SMBus read word, about 0.6 ms at 100 kHz.
+  void run(void);
+  void runSlice(uint16_t us) { _slice = us; }
+  // Jobs that finished after the next one should have started.
+  uint16_t missedDeadlines(uint8_t task) { return _tasks[task].missed; }
+
   // Digital outputs (unchecked).
   inline void digitalOut0Write(uint8_t value) { digitalWrite(pinDigitalOut0,value); }
   inline void digitalOut1Write(uint8_t value) { digitalWrite(pinDigitalOut1,value); }
@@ -146,14 +288,28 @@ public:
   uint8_t pushbutton1Read(void) { return digitalReadChecked(hasPushbutton1,pinPushbutton1); }
   uint8_t pushbutton2Read(void) { return digitalReadChecked(hasPushbutton2,pinPushbutton2); }
 
-  LiquidCrystal lcd;
+  LiquidCrystalFast<pinLcdRs,pinLcdE,pinLcdD4,pinLcdD5,pinLcdD6,pinLcdD7> lcd;
   SHT1x sht11;
   MLX90614 mlx90614;
   DS1820 ds18b20;
 
 private:
   uint32_t _peripherals;
+  MpsBus _bus;
+  int16_t _infrared; // centi-degrees
+  uint8_t _infraredStatus;
+#ifdef __MLX90614_ASYNC_TWI__
+  MLX90614Transfer _infraredTransfer;
+#endif /* __MLX90614_ASYNC_TWI__ */
+  MpsTask _tasks[MPS_TASKS_MAX];
+  uint8_t _taskCount;
+  uint32_t _scheduled; // peripherals sampled by the scheduler
+  uint16_t _slice;
+  MpsHumidity _humidity;
+  MpsThermometer _thermometer;
 
+  boolean taskStep(MpsTask& task);
+  boolean taskBusy(uint32_t peripheral);
   void digitalWriteChecked(uint32_t hasPeripheral, uint8_t pin, uint8_t value);
   int8_t digitalReadChecked(uint32_t hasPeripheral, uint8_t pin);
 };
@@ -0,0 +1,234 @@
+/*
+ * Library for use with PolyValens Multipurpose Shield 129009-1
+ *
+ * Belongs to:
+ * "Mastering Microcontrollers Helped by Arduino"
+ * ISBN 978-1-907920-23-3 (English)
+ * ISBN 978-2-86661-190-3 (French)
+ * ISBN 978-3-89576-296-3 (German)
+ * http://www.polyvalens.com/
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __MULTIPURPOSESHIELDFIXED_H__
+#define __MULTIPURPOSESHIELDFIXED_H__
+
+
+#include "MultipurposeShield.h"
+
+
+// Placeholder for the driver of a peripheral that is not fitted.
+struct MpsNone {};
+
+template <bool fitted, class T>
+struct MpsMember
+{
+  typedef T type;
+};
+
+template <class T>
+struct MpsMember<false,T>
+{
+  typedef MpsNone type;
+};
+
+// Calls that must compile whether or not the driver exists.
+inline void mpsLcdBegin(MpsNone&) {}
+template <class T>
+inline void mpsLcdBegin(T& lcd)
+{
+  lcd.init();
+  lcd.begin(16,2);
+}
+
+
+// MultipurposeShield with the peripherals fixed at compile time:
+//
+//   MultipurposeShieldFixed<hasLcd|hasLed1|hasThermometer> shield;
+//
+// Drivers of peripherals that are not fitted are left out, their members
+// shrink to an empty placeholder. Functions of peripherals that are not
+// fitted, or peripherals sharing a pin, do not compile. The availability
+// checks are constants and cost nothing at run time.
+template <uint32_t peripherals>
+class MultipurposeShieldFixed
+{
+  static_assert((peripherals&(hasDigitalIn0|hasDigitalOut0))!=(hasDigitalIn0|hasDigitalOut0),"hasDigitalIn0 and hasDigitalOut0 share pin 0");
+  static_assert((peripherals&(hasDigitalIn1|hasDigitalOut1))!=(hasDigitalIn1|hasDigitalOut1),"hasDigitalIn1 and hasDigitalOut1 share pin 1");
+  static_assert((peripherals&(hasPushbutton1|hasTransistor2))!=(hasPushbutton1|hasTransistor2),"hasPushbutton1 and hasTransistor2 share pin 9");
+  static_assert((peripherals&(hasPushbutton2|hasTransistor1))!=(hasPushbutton2|hasTransistor1),"hasPushbutton2 and hasTransistor1 share pin 10");
+  static_assert((peripherals&(hasLed1|hasBuzzer))!=(hasLed1|hasBuzzer),"hasLed1 and hasBuzzer share pin 11");
+  static_assert((peripherals&(hasLightSensor|hasMicrophone))!=(hasLightSensor|hasMicrophone),"hasLightSensor and hasMicrophone share pin A0");
+
+public:
+  void begin(void)
+  {
+    if (has(hasDigitalIn0)) pinMode(pinDigitalIn0,INPUT_PULLUP);
+    if (has(hasDigitalOut0)) output(pinDigitalOut0);
+    if (has(hasDigitalIn1)) pinMode(pinDigitalIn1,INPUT_PULLUP);
+    if (has(hasDigitalOut1)) output(pinDigitalOut1);
+    if (has(hasLcd)) mpsLcdBegin(lcd);
+    if (has(hasRcDetector)) pinMode(pinRcDetector,INPUT_PULLUP);
+    if (has(hasPushbutton1)) pinMode(pinPushbutton1,INPUT_PULLUP);
+    if (has(hasTransistor2)) output(pinTransistor2);
+    if (has(hasPushbutton2)) pinMode(pinPushbutton2,INPUT_PULLUP);
+    if (has(hasTransistor1)) output(pinTransistor1);
+    if (has(hasLed1)) output(pinLed1);
+    if (has(hasBuzzer)) output(pinBuzzer);
+    if (has(hasLed2)) output(pinLed2);
+  }
+
+  // One-wire thermometer IC2 DS18B20, pipelined like in
+  // MultipurposeShield.
+  float thermometerRead(void)
+  {
+    int16_t value;
+    if (thermometerReadCenti(value)!=statusOk) return FLT_MAX;
+    return value/100.0;
+  }
+
+  uint8_t thermometerReadCenti(int16_t& value)
+  {
+    static_assert(has(hasThermometer),"hasThermometer not fitted");
+    return _thermometer.read(ds18b20,value);
+  }
+
+  // Pressure sensor IC3 MPX4115.
+  int16_t pressureSensorRead(int16_t offset=0)
+  {
+    static_assert(has(hasPressureSensor),"hasPressureSensor not fitted");
+    return (17*(analogRead(pinPressureSensor)+offset) + 1714) >> 4;
+  }
+
+  // Humidity sensor IC4 SHT11, one snapshot shared by the getters.
+  boolean humiditySensorRead(void)
+  {
+    static_assert(has(hasHumiditySensor),"hasHumiditySensor not fitted");
+    return _humidity.read(sht11,_bus);
+  }
+
+  boolean humiditySensorRefresh(void)
+  {
+    static_assert(has(hasHumiditySensor),"hasHumiditySensor not fitted");
+    return _humidity.refresh(sht11,_bus);
+  }
+
+  void humiditySensorMaxAge(uint32_t ms) { _humidity.maxAge(ms); }
+  float humiditySensorReadRh(void) { return humiditySensorRead()==true? _humidity.rh() : FLT_MAX; }
+  float humiditySensorReadT(void) { return humiditySensorRead()==true? _humidity.t() : FLT_MAX; }
+  float humiditySensorReadDewPoint(void) { return humiditySensorRead()==true? _humidity.dewPoint() : FLT_MAX; }
+
+  uint8_t humiditySensorReadTCenti(int16_t& value)
+  {
+    value = 0;
+    if (humiditySensorRead()==false) return statusSensorError;
+    value = _humidity.tCenti();
+    return statusOk;
+  }
+
+  uint8_t humiditySensorReadDewPointCenti(int16_t& value)
+  {
+    value = 0;
+    if (humiditySensorRead()==false) return statusSensorError;
+    value = _humidity.dewPointCenti();
+    return statusOk;
+  }
+
+  // Call after using A4/A5 outside the shield.
+  void busChanged(void) { _bus.changed(); }
+
+  // Infrared thermometer IC5 MLX90614.
+  float infraredThermometerRead(void)
+  {
+    int16_t value;
+    if (infraredThermometerReadCenti(value)!=statusOk) return FLT_MAX;
+    return value/100.0;
+  }
+
+  uint8_t infraredThermometerReadCenti(int16_t& value)
+  {
+    static_assert(has(hasIrThermometer),"hasIrThermometer not fitted");
+    _bus.selectTwi(mlx90614);
+    if (mlx90614.readCenti(value)!=MLX90614_OK) return statusSensorError;
+    return statusOk;
+  }
+
+  // Light sensor LDR1.
+  int16_t lightSensorRead(boolean asPercentage=true)
+  {
+    static_assert(has(hasLightSensor),"hasLightSensor not fitted");
+    // The LDR gives a high reading for low light levels, so invert it.
+    int32_t l = 1023 - analogRead(pinLightSensor);
+    if (asPercentage==true) return (int16_t) (100*l/1023);
+    return (int16_t) l;
+  }
+
+  // Digital IO.
+  void digitalOut0Write(uint8_t value) { write<hasDigitalOut0>(pinDigitalOut0,value); }
+  void digitalOut1Write(uint8_t value) { write<hasDigitalOut1>(pinDigitalOut1,value); }
+  uint8_t digitalIn0Read(void) { return read<hasDigitalIn0>(pinDigitalIn0); }
+  uint8_t digitalIn1Read(void) { return read<hasDigitalIn1>(pinDigitalIn1); }
+
+  // LEDs.
+  void led1Write(uint8_t value) { write<hasLed1>(pinLed1,value); }
+  void led2Write(uint8_t value) { write<hasLed2>(pinLed2,value); }
+
+  // Transistors.
+  void transistor1Write(uint8_t value) { write<hasTransistor1>(pinTransistor1,value); }
+  void transistor2Write(uint8_t value) { write<hasTransistor2>(pinTransistor2,value); }
+
+  // Pushbuttons.
+  uint8_t pushbutton1Read(void) { return read<hasPushbutton1>(pinPushbutton1); }
+  uint8_t pushbutton2Read(void) { return read<hasPushbutton2>(pinPushbutton2); }
+
+  typename MpsMember<(peripherals&hasLcd)!=0,LiquidCrystalFast<pinLcdRs,pinLcdE,pinLcdD4,pinLcdD5,pinLcdD6,pinLcdD7> >::type lcd;
+  typename MpsMember<(peripherals&hasHumiditySensor)!=0,SHT1x>::type sht11;
+  typename MpsMember<(peripherals&hasIrThermometer)!=0,MLX90614>::type mlx90614;
+  typename MpsMember<(peripherals&hasThermometer)!=0,DS1820>::type ds18b20;
+
+private:
+  typename MpsMember<(peripherals&(hasHumiditySensor|hasIrThermometer))!=0,MpsBus>::type _bus;
+  typename MpsMember<(peripherals&hasHumiditySensor)!=0,MpsHumidity>::type _humidity;
+  typename MpsMember<(peripherals&hasThermometer)!=0,MpsThermometer>::type _thermometer;
+
+  static constexpr bool has(uint32_t peripheral) { return (peripherals&peripheral)!=0; }
+
+  static void output(uint8_t pin)
+  {
+    pinMode(pin,OUTPUT);
+    digitalWrite(pin,LOW);
+  }
+
+  // Instantiated only when used, so only an unfitted peripheral that is
+  // actually accessed fails to compile.
+  template <uint32_t peripheral>
+  static inline void write(uint8_t pin, uint8_t value)
+  {
+    static_assert(has(peripheral),"peripheral not fitted");
+    digitalWrite(pin,value);
+  }
+
+  template <uint32_t peripheral>
+  static inline uint8_t read(uint8_t pin)
+  {
+    static_assert(has(peripheral),"peripheral not fitted");
+    return digitalRead(pin);
+  }
+};
+
+
+#endif /* __MULTIPURPOSESHIELDFIXED_H__ */
@@ -1,6 +1,6 @@
 /*
  * Arduino driver for SHT1x temperature & relative humidity sensor.
- * Handles CRC (optional).
+ * Handles CRC.
  *
  * Belongs to:
  * "Mastering Microcontrollers Helped by Arduino"
@@ -42,122 +42,382 @@ const float C3 = -0.0000015955;  // for 12 Bit RH
 const float T1 = +0.01;  // for 12 Bit RH
 const float T2 = +0.00008;  // for 12 Bit RH	
 
+const float C1_LOW = -2.0468;  // for 8 Bit RH
+const float C2_LOW = +0.5872;  // for 8 Bit RH
+const float C3_LOW = -0.00040845;  // for 8 Bit RH
+const float T1_LOW = +0.01;  // for 8 Bit RH
+const float T2_LOW = +0.00128;  // for 8 Bit RH
+
+
+// ln(1+i/16) in Q12 for the fixed-point dew point.
+static const uint16_t ln_table[17] PROGMEM =
+{
+  0, 248, 482, 704, 914, 1114, 1304, 1486, 1661,
+  1828, 1989, 2143, 2292, 2436, 2575, 2709, 2839
+};
+
 
 static uint8_t debug = 0;
 
 
+#ifdef __SHT1X_FAST_IO__
+// Port writes are only a few cycles apart, respect the 100 ns setup and
+// hold times of the sensor.
+#define SHT1X_WAIT()  delayMicroseconds(1)
+#else
+// digitalWrite() takes several microseconds by itself.
+#define SHT1X_WAIT()
+#endif /* __SHT1X_FAST_IO__ */
+
+
 void SHT1x::begin(uint8_t data, uint8_t sck, boolean disable_twi)
 {
   _data = data;
   _sck = sck;
+#ifdef __SHT1X_FAST_IO__
+  _data_out = portOutputRegister(digitalPinToPort(data));
+  _data_mode = portModeRegister(digitalPinToPort(data));
+  _data_in = portInputRegister(digitalPinToPort(data));
+  _data_mask = digitalPinToBitMask(data);
+  _sck_out = portOutputRegister(digitalPinToPort(sck));
+  _sck_mode = portModeRegister(digitalPinToPort(sck));
+  _sck_mask = digitalPinToBitMask(sck);
+#endif /* __SHT1X_FAST_IO__ */
   _temperature = 0.0;
   _humidity = 0.0;
+  _raw_temperature = 0;
+  _raw_humidity = 0;
+  _ready = true;
+  _error = false;
   connection_reset();
-  if (disable_twi==true)
-  {
-    // In case the sensor shares the TWI bus.
-    // Calling Wire.begin will restore this.
-    TWCR &= ~(_BV(TWEN) | _BV(TWIE) | _BV(TWEA));
-  }
+  if (disable_twi==true) this->disable_twi();
+  // The sensor keeps its settings over a reset of the Arduino.
+  uint8_t crc2;
+  if (status_register_read(_status,crc2)==true) _status = 0;
+  _status &= SHT1X_STATUS_LOW_RESOLUTION | SHT1X_STATUS_NO_OTP_RELOAD | SHT1X_STATUS_HEATER;
 }
 
 
-void SHT1x::update(void)
+// Returns true if one of the measurements failed, its previous value is
+// kept.
+boolean SHT1x::update(void)
 {
-  int t;
-  int h;
-  uint8_t crc2;
   boolean error;
-  
-#ifdef __USE_CRC__
-  uint8_t stat;
-  error = status_register_read(stat,crc2);
-  if (error==false)
+  start_temperature();
+  while (poll()==false);
+  error = _error;
+  start_humidity();
+  while (poll()==false);
+  error |= _error;
+
+  if (debug)
   {
-    crc.set(crc.bit_reverse(stat));
+    Serial.print("T=");
+    Serial.print(_temperature);
+    Serial.print(", RH=");
+    Serial.print(_humidity);
+    Serial.print("%, dew point=");
+    Serial.println(get_dewpoint());
   }
-  else
-  {
-    if (debug) Serial.println("status ack error");
-    crc.reset();
-  }
-#endif /* __USE_CRC__ */
+  return error;
+}
 
-  error = measure(t,crc2,SHT1X_CMD_READ_TEMPERATURE);
-#ifdef __USE_CRC__
-  if (crc.get()!=0)
-  {
-    if (debug) Serial.println("Temperature CRC error.");
-  }
-#endif /* __USE_CRC__ */
 
-  error |= measure(h,crc2,SHT1X_CMD_READ_REL_HUMIDITY);
-#ifdef __USE_CRC__
-  if (crc.get()!=0)
-  {
-    if (debug) Serial.println("Humidity CRC error.");
-  }
-#endif /* __USE_CRC__ */
+// In case the sensor shares the TWI bus.
+// Calling Wire.begin will restore this.
+void SHT1x::disable_twi(void)
+{
+  TWCR &= ~(_BV(TWEN) | _BV(TWIE) | _BV(TWEA));
+}
+
 
-  if (error==false)
+boolean SHT1x::start_temperature(void)
+{
+  return start_measurement(SHT1X_CMD_READ_TEMPERATURE);
+}
+
+
+boolean SHT1x::start_humidity(void)
+{
+  return start_measurement(SHT1X_CMD_READ_REL_HUMIDITY);
+}
+
+
+// Returns true when the measurement is done, the result is then
+// available through the get_ functions unless the sensor failed.
+boolean SHT1x::poll(void)
+{
+  if (_ready==false)
   {
-    _temperature = t;
-    _humidity = h;
-    calculcate();
-    if (debug)
+    // The sensor pulls the data line low when the measurement is done.
+    if (data_read()==0)
     {
-      Serial.print("T=");
-      Serial.print(_temperature);
-      Serial.print(", RH=");
-      Serial.print(_humidity);
-      Serial.print("%, dew point=");
-      Serial.println(get_dewpoint());
+      if (read_measurement()==false)
+      {
+        _ready = true;
+      }
+      else if (retry()==true)
+      {
+        resend_measurement();
+      }
+      else
+      {
+        _error = true;
+        _ready = true;
+      }
+    }
+    else if (millis()-_start>SHT1X_TIMEOUT)
+    {
+      if (debug) Serial.println("measure timeout");
+      if (retry()==true)
+      {
+        connection_reset();
+        resend_measurement();
+      }
+      else
+      {
+        _error = true;
+        _ready = true;
+      }
     }
   }
-  else
-  {
-    if (debug) Serial.println("measure ack error");
-  }
+  return _ready;
+}
+
+
+// Low resolution measures 12-bit T and 8-bit RH instead of 14 and 12 bit.
+boolean SHT1x::set_resolution(boolean low)
+{
+  return status_register_update(SHT1X_STATUS_LOW_RESOLUTION,low);
+}
+
+
+// The heater warms the sensor by 5 to 10 degrees, e.g. to check it works.
+boolean SHT1x::set_heater(boolean on)
+{
+  return status_register_update(SHT1X_STATUS_HEATER,on);
+}
+
+
+// Not reloading the calibration data from OTP before every measurement
+// saves about 10 ms.
+boolean SHT1x::set_otp_reload(boolean reload)
+{
+  return status_register_update(SHT1X_STATUS_NO_OTP_RELOAD,!reload);
+}
+
+
+void SHT1x::reset_counters(void)
+{
+  _counters.crc_errors = 0;
+  _counters.ack_errors = 0;
+  _counters.retries = 0;
 }
 
 
 float SHT1x::get_dewpoint(void)
 { 
-  float k = (log10(_humidity)-2)/0.4343 + (17.62*_temperature)/(243.12+_temperature);
+  return calculate_dewpoint(_temperature,_humidity);
+}
+
+
+float SHT1x::calculate_dewpoint(float temperature, float humidity)
+{
+  float k = (log10(humidity)-2)/0.4343 + (17.62*temperature)/(243.12+temperature);
   return 243.12*k/(17.62-k);
 }
 
 
+inline void SHT1x::sck_output(void)
+{
+#ifdef __SHT1X_FAST_IO__
+  uint8_t sreg = SREG;
+  cli();
+  *_sck_mode |= _sck_mask;
+  SREG = sreg;
+#else
+  pinMode(_sck,OUTPUT);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+inline void SHT1x::sck_write(uint8_t value)
+{
+#ifdef __SHT1X_FAST_IO__
+  uint8_t sreg = SREG;
+  cli();
+  if (value!=0) *_sck_out |= _sck_mask;
+  else *_sck_out &= ~_sck_mask;
+  SREG = sreg;
+#else
+  digitalWrite(_sck,value);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+inline void SHT1x::data_output(void)
+{
+#ifdef __SHT1X_FAST_IO__
+  uint8_t sreg = SREG;
+  cli();
+  *_data_mode |= _data_mask;
+  SREG = sreg;
+#else
+  pinMode(_data,OUTPUT);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+inline void SHT1x::data_input(void)
+{
+#ifdef __SHT1X_FAST_IO__
+  uint8_t sreg = SREG;
+  cli();
+  *_data_mode &= ~_data_mask;
+  *_data_out |= _data_mask; // pull-up
+  SREG = sreg;
+#else
+  pinMode(_data,INPUT_PULLUP);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+inline void SHT1x::data_write(uint8_t value)
+{
+#ifdef __SHT1X_FAST_IO__
+  uint8_t sreg = SREG;
+  cli();
+  if (value!=0) *_data_out |= _data_mask;
+  else *_data_out &= ~_data_mask;
+  SREG = sreg;
+#else
+  digitalWrite(_data,value);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+inline uint8_t SHT1x::data_read(void)
+{
+#ifdef __SHT1X_FAST_IO__
+  return (*_data_in & _data_mask)!=0;
+#else
+  return digitalRead(_data);
+#endif /* __SHT1X_FAST_IO__ */
+}
+
+
+int16_t SHT1x::get_temperature_centi(void)
+{
+  // d1 = -40.1, d2 = 0.01 (14 bits) or 0.04 (12 bits) @ 5V
+  if ((_status&SHT1X_STATUS_LOW_RESOLUTION)!=0) return 4*(_raw_temperature&0x0fff) - 4010;
+  return (_raw_temperature&0x3fff) - 4010;
+}
+
+
+uint16_t SHT1x::get_humidity_centi(void)
+{
+  return (humidity_fixed() + 50)/100;
+}
+
+
+// Relative humidity in 0.0001 %RH, same polynomials as calculcate(). The
+// square is scaled to fit in 32 bits: 4183/1024 = 4.0850.
+int32_t SHT1x::humidity_fixed(void)
+{
+  int32_t so = _raw_humidity & 0x0fff;
+  int32_t t = get_temperature_centi() - 2500;
+  int32_t rh;
+  if ((_status&SHT1X_STATUS_LOW_RESOLUTION)!=0)
+  {
+    so &= 0xff;
+    rh = -20468 + 5872*so - ((so*so*4183)>>10);
+    rh += t*(3125 + 4*(rh/100))/3125;  // t1 = 0.01, t2 = 0.00128
+  }
+  else
+  {
+    rh = -20468 + 367*so - ((((so*so)>>8)*4183)>>10);
+    rh += t*(12500 + rh/100)/12500;  // t1 = 0.01, t2 = 0.00008
+  }
+  return constrain(rh,1000,1000000);
+}
+
+
+// ln(rh/1000000) in Q12 for rh in 0.0001 %RH, from the position of the
+// most significant bit and a linear interpolation of ln on [1,2).
+static int32_t ln_rh(uint32_t rh)
+{
+  int32_t n = 31;
+  while ((rh&0x80000000)==0)
+  {
+    rh <<= 1;
+    n--;
+  }
+  uint8_t i = (rh>>27) & 0x0f;
+  int32_t f = (rh>>16) & 0x07ff;
+  int32_t a = pgm_read_word(&ln_table[i]);
+  int32_t b = pgm_read_word(&ln_table[i+1]);
+  // ln(2) = 22713/8/4096, ln(1000000) = 56588/4096
+  return ((n*22713)>>3) + a + (((b-a)*f)>>11) - 56588;
+}
+
+
+// Magnus formula like get_dewpoint() in Q12 fixed point. Over the full
+// range of raw sensor values the result stays within 0.05 degrees of the
+// float version, humidity within 0.01 %RH.
+int16_t SHT1x::get_dewpoint_centi(void)
+{
+  int32_t t = get_temperature_centi();
+  // 17.62*T/(243.12+T) = 1762*t/(100*(24312+t)), divided in two steps
+  // to stay within 32 bits.
+  int32_t n = 1762*t;
+  int32_t d = 24312 + t;
+  int32_t k = ((n/d)*4096 + ((n%d)*4096)/d)/100;
+  k += ln_rh(humidity_fixed());
+  // 243.12*k/(17.62-k)
+  d = 72172 - k;
+  n = 24312*k;
+  return (n + (n<0? -d/2 : d/2))/d;
+}
+
+
 void SHT1x::strobe(void)
 {
-  digitalWrite(_sck,HIGH);
-  delay(1);
-  digitalWrite(_sck,LOW);
+  // SCK high and low time are 100 ns minimum, no need for milliseconds.
+  SHT1X_WAIT();
+  sck_write(HIGH);
+  SHT1X_WAIT();
+  sck_write(LOW);
 }
 
 
 void SHT1x::start_sequence(void)
 {
-  pinMode(_data,OUTPUT);
-  pinMode(_sck,OUTPUT);
-  digitalWrite(_data,HIGH);
-  digitalWrite(_sck,LOW);
-  digitalWrite(_sck,HIGH);
-  digitalWrite(_data,LOW);
-  digitalWrite(_sck,LOW);
-  digitalWrite(_sck,HIGH);
-  digitalWrite(_data,HIGH);
-  digitalWrite(_sck,LOW);
+  data_output();
+  sck_output();
+  data_write(HIGH);
+  sck_write(LOW);
+  SHT1X_WAIT();
+  sck_write(HIGH);
+  SHT1X_WAIT();
+  data_write(LOW);
+  SHT1X_WAIT();
+  sck_write(LOW);
+  SHT1X_WAIT();
+  sck_write(HIGH);
+  SHT1X_WAIT();
+  data_write(HIGH);
+  SHT1X_WAIT();
+  sck_write(LOW);
 }
 
 
 void SHT1x::connection_reset(void)
 {
   int i;
-  pinMode(_data,OUTPUT);
-  pinMode(_sck,OUTPUT);
-  digitalWrite(_data,HIGH);
-  digitalWrite(_sck,LOW);
+  data_output();
+  sck_output();
+  data_write(HIGH);
+  sck_write(LOW);
   for (i=0; i<9; i++)
   {
     strobe();
@@ -181,20 +441,22 @@ boolean SHT1x::send_byte(uint8_t value)
   uint8_t i;
   boolean error = true;
 
-  pinMode(_data,OUTPUT);
-  pinMode(_sck,OUTPUT);
+  data_output();
+  sck_output();
   
   for (i=0x80; i>0; i>>=1)
   {
-    if ((value&i)!=0) digitalWrite(_data,HIGH);
-    else digitalWrite(_data,LOW);
+    if ((value&i)!=0) data_write(HIGH);
+    else data_write(LOW);
     strobe();
   }
 
-  pinMode(_data,INPUT_PULLUP);  
-  digitalWrite(_sck,HIGH);
-  if (digitalRead(_data)==0) error = false;
-  digitalWrite(_sck,LOW);
+  data_input();
+  SHT1X_WAIT();
+  sck_write(HIGH);
+  SHT1X_WAIT();
+  if (data_read()==0) error = false;
+  sck_write(LOW);
   return error;
 }
 
@@ -204,19 +466,22 @@ uint8_t SHT1x::receive_byte(uint8_t ack)
   int i;
   uint8_t value = 0;
 
-  pinMode(_data,INPUT_PULLUP);  
+  data_input();
   
   for (i=0x80; i>0; i/=2)
   {
-    digitalWrite(_sck,HIGH);
-    if (digitalRead(_data)!=0) value |= i;
-    digitalWrite(_sck,LOW);
+    // Data is valid 250 ns after the falling edge of SCK.
+    SHT1X_WAIT();
+    sck_write(HIGH);
+    if (data_read()!=0) value |= i;
+    SHT1X_WAIT();
+    sck_write(LOW);
   }
   
-  pinMode(_data,OUTPUT);  
-  digitalWrite(_data,ack);
+  data_output();
+  data_write(ack);
   strobe();
-  digitalWrite(_data,HIGH);
+  data_write(HIGH);
 
   return value;
 }
@@ -243,47 +508,107 @@ boolean SHT1x::status_register_write(uint8_t value)
 }
 
 
-boolean SHT1x::wait_for_measurement(void)
+boolean SHT1x::status_register_update(uint8_t mask, boolean set)
+{ 
+  uint8_t value = set==true? _status|mask : _status&~mask;
+  boolean error = status_register_write(value);
+  if (error==false) _status = value;
+  return error;
+}
+
+
+boolean SHT1x::start_measurement(uint8_t command)
+{
+  _command = command;
+  _attempts = 0;
+  resend_measurement();
+  return _error;
+}
+
+
+boolean SHT1x::send_measurement(void)
+{
+  start_sequence();
+  _error = send_byte(_command);
+  // The CRC starts from the reversed low nibble of the status register.
+  crc.set(crc.bit_reverse(_status&0x0f));
+  crc.update(_command);
+  _start = millis();
+  if (_error==true)
+  {
+    _counters.ack_errors++;
+    if (debug) Serial.println("measure ack error");
+  }
+  data_input();
+  return _error;
+}
+
+
+// Sends the measurement command until the sensor acknowledges it or the
+// retries run out.
+void SHT1x::resend_measurement(void)
 {
-  pinMode(_data,INPUT_PULLUP);  
-  while (digitalRead(_data)!=0);
+  while (send_measurement()==true && retry()==true)
+  {
+    connection_reset();
+  }
+  // Without an acknowledge there is no measurement to wait for.
+  _ready = _error;
+}
+
+
+// Returns true if another attempt is allowed.
+boolean SHT1x::retry(void)
+{
+  if (_attempts>=_max_retries) return false;
+  _attempts++;
+  _counters.retries++;
   return true;
 }
 
 
-boolean SHT1x::measure(int& result, uint8_t& crc2, uint8_t command)
+// Returns true if the frame is corrupt, the result is then discarded.
+boolean SHT1x::read_measurement(void)
 {
-  boolean error;
+  uint16_t result;
   uint8_t temp;
-  start_sequence();
-  error = send_byte(command);
-#ifdef __USE_CRC__
-  crc.reset();
-  crc.update(command);
-#endif /* __USE_CRC__ */
-  wait_for_measurement();
+  uint8_t crc2;
   temp = receive_byte(LOW);
-#ifdef __USE_CRC__
   crc.update(temp);
-#endif /* __USE_CRC__ */
   result = temp << 8;
   temp = receive_byte(LOW);
-#ifdef __USE_CRC__
   crc.update(temp);
-#endif /* __USE_CRC__ */
   result += temp;
   crc2 = receive_byte(HIGH);
-#ifdef __USE_CRC__
   crc.update(crc.bit_reverse(crc2)); // Now CRC should equal 0.
-#endif /* __USE_CRC__ */
-  return error;
+  if (crc.get()!=0)
+  {
+    _counters.crc_errors++;
+    if (debug) Serial.println(_command==SHT1X_CMD_READ_TEMPERATURE? "Temperature CRC error." : "Humidity CRC error.");
+    if (_crc_check==true) return true;
+  }
+
+  if (_command==SHT1X_CMD_READ_TEMPERATURE) _raw_temperature = result;
+  else _raw_humidity = result;
+  calculcate();
+  return false;
 }
 
 
 void SHT1x::calculcate()
 { 
-  _temperature = _temperature*0.01 - 40.1;  // [degrees C], 14 bits @ 5V
-  _humidity = C3*_humidity*_humidity + C2*_humidity + C1;  // [%RH]
-  _humidity = (_temperature-25)*(T1+T2*_humidity) + _humidity;  // _temperature compensated _humidity [%RH]
+  _humidity = _raw_humidity;
+  if ((_status&SHT1X_STATUS_LOW_RESOLUTION)!=0)
+  {
+    _temperature = _raw_temperature*0.04 - 40.1;  // [degrees C], 12 bits @ 5V
+    _humidity = C3_LOW*_humidity*_humidity + C2_LOW*_humidity + C1_LOW;  // [%RH]
+    _humidity = (_temperature-25)*(T1_LOW+T2_LOW*_humidity) + _humidity;  // _temperature compensated _humidity [%RH]
+  }
+  else
+  {
+    _temperature = _raw_temperature*0.01 - 40.1;  // [degrees C], 14 bits @ 5V
+    _humidity = C3*_humidity*_humidity + C2*_humidity + C1;  // [%RH]
+    _humidity = (_temperature-25)*(T1+T2*_humidity) + _humidity;  // _temperature compensated _humidity [%RH]
+  }
   _humidity = constrain(_humidity,0.1,100);
 }
@@ -1,6 +1,6 @@
 /*
  * Arduino driver for SHT1x temperature & relative humidity sensor.
- * Handles CRC (optional).
+ * Handles CRC.
  *
  * Belongs to:
  * "Mastering Microcontrollers Helped by Arduino"
@@ -31,31 +31,28 @@
 #define __SHT1x_H__
 
 #include "Arduino.h"
+#include "../crc8/crc8.h"
 
 
-//#define __USE_CRC__
+// Bit-bang through the port registers instead of digitalWrite() and
+// digitalRead(), clocking the sensor at a few hundred kHz.
+//#define __SHT1X_FAST_IO__
 
 
-#ifdef __USE_CRC__
-static const uint8_t crc_table[256] =
-{
-    0,  49,  98,  83, 196, 245, 166, 151, 185, 136, 219, 234, 125,  76,  31,  46,
-   67, 114,  33,  16, 135, 182, 229, 212, 250, 203, 152, 169,  62,  15,  92, 109,
-  134, 183, 228, 213,  66, 115,  32,  17,  63,  14,  93, 108, 251, 202, 153, 168,
-  197, 244, 167, 150,   1,  48,  99,  82, 124,  77,  30,  47, 184, 137, 218, 235,
-   61,  12,  95, 110, 249, 200, 155, 170, 132, 181, 230, 215,  64, 113,  34,  19,
-  126,  79,  28,  45, 186, 139, 216, 233, 199, 246, 165, 148,   3,  50,  97,  80,
-  187, 138, 217, 232, 127,  78,  29,  44,   2,  51,  96,  81, 198, 247, 164, 149,
-  248, 201, 154, 171,  60,  13,  94, 111,  65, 112,  35,  18, 133, 180, 231, 214,
-  122,  75,  24,  41, 190, 143, 220, 237, 195, 242, 161, 144,   7,  54, 101,  84,
-   57,   8,  91, 106, 253, 204, 159, 174, 128, 177, 226, 211,  68, 117,  38,  23,
-  252, 205, 158, 175,  56,   9,  90, 107,  69, 116,  39,  22, 129, 176, 227, 210,
-  191, 142, 221, 236, 123,  74,  25,  40,   6,  55, 100,  85, 194, 243, 160, 145,
-   71, 118,  37,  20, 131, 178, 225, 208, 254, 207, 156, 173,  58,  11,  88, 105,
-    4,  53, 102,  87, 192, 241, 162, 147, 189, 140, 223, 238, 121,  72,  27,  42,
-  193, 240, 163, 146,   5,  52, 103,  86, 120,  73,  26,  43, 188, 141, 222, 239,
-  130, 179, 224, 209,  70, 119,  36,  21,  59,  10,  89, 104, 255, 206, 157, 172
-};
+// Status register bits.
+#define SHT1X_STATUS_LOW_RESOLUTION  0x01 /* 12-bit T & 8-bit RH, 4x faster */
+#define SHT1X_STATUS_NO_OTP_RELOAD  0x02 /* skip reloading calibration data */
+#define SHT1X_STATUS_HEATER  0x04
+#define SHT1X_STATUS_LOW_BATTERY  0x40 /* read-only, VDD < 2.47 V */
+
+
+// A 14-bit measurement takes up to 320 ms.
+#define SHT1X_TIMEOUT  500 /* ms */
+
+// Measurements with a CRC or acknowledge error are repeated this many
+// times before giving up.
+#define SHT1X_RETRIES  2
+
 
 class SHT1x_crc
 {
@@ -63,7 +60,7 @@ public:
   uint8_t get(void) { return _crc; }
   void set(uint8_t value) { _crc = value; }
   void reset(void) { set(0); }
-  void update(uint8_t value) { _crc = crc_table[value^_crc]; }
+  void update(uint8_t value) { _crc = crc8_sht1x(_crc,value); }
 
   // Adapted from http://graphics.stanford.edu/~seander/bithacks.html
   uint8_t bit_reverse(uint8_t value)
@@ -82,22 +79,63 @@ public:
 private:
   uint8_t _crc;
 };
-#endif /* __USE_CRC__ */
+
+
+struct SHT1x_counters
+{
+  uint16_t crc_errors;
+  uint16_t ack_errors;
+  uint16_t retries;
+};
 
 
 class SHT1x
 {
 public:
-  SHT1x(void) {}
-  SHT1x(uint8_t data, uint8_t sck, boolean disable_twi) { begin(data,sck,disable_twi); }
+  SHT1x(void) : _crc_check(true), _max_retries(SHT1X_RETRIES) { reset_counters(); }
+  SHT1x(uint8_t data, uint8_t sck, boolean disable_twi) : _crc_check(true), _max_retries(SHT1X_RETRIES)
+  {
+    reset_counters();
+    begin(data,sck,disable_twi);
+  }
 
   void begin(uint8_t data, uint8_t sck, boolean disable_twi=false);
-  void update(void);
+  boolean update(void);
+
+  // Non-blocking measurements: start one, then call poll() until it
+  // returns true. update() does both measurements this way.
+  boolean start_temperature(void);
+  boolean start_humidity(void);
+  boolean poll(void);
+  boolean result_ready(void) { return _ready; }
+  boolean result_error(void) { return _error; }
 
   float get_temperature(void) { return _temperature; }
   float get_humidity(void) { return _humidity; } 
   float get_dewpoint(void);
-
+  // Magnus formula, also for results saved elsewhere.
+  static float calculate_dewpoint(float temperature, float humidity);
+
+  // Integer versions in hundredths of degrees and %RH, no floats needed.
+  int16_t get_temperature_centi(void);
+  uint16_t get_humidity_centi(void);
+  int16_t get_dewpoint_centi(void);
+
+  // Status register settings, kept by the sensor until power down or
+  // soft reset.
+  boolean set_resolution(boolean low);
+  boolean set_heater(boolean on);
+  boolean set_otp_reload(boolean reload);
+  uint8_t get_status(void) { return _status; }
+
+  // Frames with a bad CRC are rejected and measured again, unless
+  // checking is disabled.
+  void set_crc_check(boolean check) { _crc_check = check; }
+  void set_retries(uint8_t retries) { _max_retries = retries; }
+  const SHT1x_counters& get_counters(void) { return _counters; }
+  void reset_counters(void);
+
+  void disable_twi(void);
   void start_sequence(void);
   void connection_reset(void);
   boolean soft_reset(void);
@@ -107,19 +145,48 @@ private:
   uint8_t _sck;
   float _temperature;
   float _humidity;
+  uint16_t _raw_temperature;
+  uint16_t _raw_humidity;
+  uint8_t _status; // status register contents
+  uint8_t _command; // measurement in progress
+  boolean _ready;
+  boolean _error;
+  uint32_t _start;
+  boolean _crc_check;
+  uint8_t _max_retries;
+  uint8_t _attempts;
+  SHT1x_counters _counters;
+  SHT1x_crc crc;
 
+#ifdef __SHT1X_FAST_IO__
+  volatile uint8_t *_data_out;
+  volatile uint8_t *_data_mode;
+  volatile uint8_t *_data_in;
+  uint8_t _data_mask;
+  volatile uint8_t *_sck_out;
+  volatile uint8_t *_sck_mode;
+  uint8_t _sck_mask;
+#endif /* __SHT1X_FAST_IO__ */
+
+  void sck_output(void);
+  void sck_write(uint8_t value);
+  void data_output(void);
+  void data_input(void);
+  void data_write(uint8_t value);
+  uint8_t data_read(void);
   void strobe(void);
   boolean send_byte(uint8_t value);
   uint8_t receive_byte(uint8_t ack);
   boolean status_register_read(uint8_t& result, uint8_t& crc2);
   boolean status_register_write(uint8_t value);
-  boolean wait_for_measurement(void);
-  boolean measure(int& result, uint8_t& crc2, uint8_t command);
+  boolean status_register_update(uint8_t mask, boolean set);
+  boolean start_measurement(uint8_t command);
+  boolean send_measurement(void);
+  void resend_measurement(void);
+  boolean read_measurement(void);
+  boolean retry(void);
   void calculcate(void);
-
-#ifdef __USE_CRC__
-  SHT1x_crc crc;
-#endif /* __USE_CRC__ */
+  int32_t humidity_fixed(void);
 };
 
 
@@ -0,0 +1,53 @@
+/*
+ * CRC-8 checksums for the sensor drivers.
+ *
+ * Belongs to:
+ * "Mastering Microcontrollers Helped by Arduino"
+ * ISBN 978-1-907920-23-3 (English)
+ * ISBN 978-2-86661-190-3 (French)
+ * ISBN 978-3-89576-296-3 (German)
+ * http://www.polyvalens.com/
+ *
+ * For use with PolyValens Multipurpose Shield 129009-1
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __CRC8_H__
+#define __CRC8_H__
+
+#include "Arduino.h"
+
+
+// The lookup tables are stored in flash (PROGMEM), they take no RAM.
+// By default every polynomial has a 256-byte table, one lookup per byte.
+// Define __CRC8_NIBBLE__ to use 16-byte tables instead, two lookups per
+// byte. These are the sizes of the table data only, the code of the
+// functions comes on top of it.
+//#define __CRC8_NIBBLE__
+
+
+// x^8 + x^5 + x^4 + 1, MSB first (SHT1x)
+uint8_t crc8_sht1x(uint8_t crc, uint8_t value);
+
+// x^8 + x^2 + x + 1, MSB first (SMBus PEC, MLX90614)
+uint8_t crc8_smbus(uint8_t crc, uint8_t value);
+
+// x^8 + x^5 + x^4 + 1, LSB first (Dallas/Maxim 1-Wire)
+uint8_t crc8_dallas(uint8_t crc, uint8_t value);
+
+
+#endif /* __CRC8_H__ */
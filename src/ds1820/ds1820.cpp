@@ -29,92 +29,246 @@
 #include "ds1820.h"
 
 
-#define DS1820_DQ_LO DS1820_DQ_DDR |= _BV(DS1820_DQ_BIT); \
-                     DS1820_DQ_PORT &= ~_BV(DS1820_DQ_BIT)
+static OneWireMaster& defaultBus(void)
+{
+  static OneWireBus<DS1820_DEFAULT_PORT,DS1820_DEFAULT_BIT> bus;
+  return bus;
+}
 
-#define DS1820_DQ_HI DS1820_DQ_PORT |= _BV(DS1820_DQ_BIT); \
-                     DS1820_DQ_DDR &= ~_BV(DS1820_DQ_BIT)
 
-#define DS1820_DQ_IN (DS1820_DQ_PIN & _BV(DS1820_DQ_BIT))
+DS1820::DS1820(void) : _bus(&defaultBus()), _resolution(DS1820_RESOLUTION_DEFAULT), _devices(0), _crcCheck(true)
+{
+}
 
 
-boolean DS1820::reset(void)
+float DS1820::read(void)
 {
-  boolean presence = false;
-  DS1820_DQ_LO;
-  delayMicroseconds(500);
-  DS1820_DQ_HI;
-  int timeout = 480;
-  int dt = 30;
-  while (timeout>0)
+  if (startConversion()==true && waitReady()==true)
   {
-    delayMicroseconds(dt);
-    timeout -= dt;
-    if (DS1820_DQ_IN==0)
-    {
-      presence = true;
-      break;
-    }
+    return readResult();
   }
-  // Finish timeout.
-  delayMicroseconds(timeout);
-  return presence;
+  return 0.0;
 }
 
 
-uint8_t DS1820::timeSlot(uint8_t value)
+// One conversion for all the chips in the device table, returns the
+// number of results.
+uint8_t DS1820::readAll(float *result, uint8_t size)
 {
-  uint8_t result = 0;
-  DS1820_DQ_LO;
-  delayMicroseconds(2);
-  if (value!=0) DS1820_DQ_HI;
-  delayMicroseconds(10);
-  if (DS1820_DQ_IN!=0) result = 1;
-  delayMicroseconds(50);
-  DS1820_DQ_HI;
-  return result;
+  uint8_t i;
+  if (startConversion()==false || waitReady()==false) return 0;
+  for (i=0; i<_devices && i<size; i++)
+  {
+    result[i] = readResult(i);
+  }
+  return i;
 }
 
 
-void DS1820::writeByte(uint8_t value)
+boolean DS1820::waitReady(void)
 {
-  for (uint8_t mask=0x01; mask!=0; mask<<=1)
+  uint32_t start = millis();
+  uint16_t timeout = 2*conversionTime();
+  while (isReady()==false)
   {
-    timeSlot(value&mask);
+    if (millis()-start>timeout) return false;
   }
+  return true;
 }
 
 
-uint8_t DS1820::readByte(void)
+boolean DS1820::startConversion(void)
 {
-  uint8_t result = 0;
-  for (uint8_t mask=0x01; mask!=0; mask<<=1)
+  if (reset()==true)
   {
-    if (timeSlot(1)!=0) result |= mask;
+    writeByte(0xcc);
+    writeByte(0x44);
+    return true;
   }
-  return result;
+  return false;
 }
 
 
-float DS1820::read(void)
+// The chip answers read slots with 0 while it is converting.
+boolean DS1820::isReady(void)
 {
-  float result = 0.0;
-  if (reset()==true)
+  return timeSlot(1)!=0;
+}
+
+
+float DS1820::readResult(void)
+{
+  return readResult(DS1820_MAX_DEVICES);
+}
+
+
+float DS1820::readResult(uint8_t index)
+{
+  int16_t result;
+  readTemperature(index,result);
+  return result/16.0;
+}
+
+
+uint8_t DS1820::readCenti(int16_t& result)
+{
+  result = 0;
+  if (startConversion()==false) return DS1820_NO_DEVICE;
+  if (waitReady()==false) return DS1820_TIMEOUT;
+  return readResultCenti(result);
+}
+
+
+uint8_t DS1820::readResultCenti(int16_t& result, uint8_t index)
+{
+  uint8_t status = readTemperature(index,result);
+  // 100/16 = 25/4, rounded.
+  int32_t t = 25*(int32_t)result;
+  result = (t + (t<0? -2 : 2))/4;
+  return status;
+}
+
+
+// Temperature register in 1/16 degrees.
+uint8_t DS1820::readTemperature(uint8_t index, int16_t& result)
+{
+  result = 0;
+  uint8_t status = readScratchpad(index,_crcCheck==true? DS1820_SCRATCHPAD_SIZE : 2);
+  if (status==DS1820_OK)
   {
-    writeByte(0xcc);
-    writeByte(0x44);
-    while (timeSlot(1)==0);
-    if (reset()==true)
+    // The low bits are undefined below 12 bits resolution.
+    uint8_t lsb = _scratchpad[0] & (0xff<<(12-_resolution));
+    result = (_scratchpad[1]<<8) | lsb;
+  }
+  return status;
+}
+
+
+// Addresses one chip with Match ROM, or all of them with Skip ROM when
+// the index is not in the device table.
+boolean DS1820::select(uint8_t index)
+{
+  if (reset()==false) return false;
+  if (index<_devices)
+  {
+    writeByte(0x55);
+    for (uint8_t i=0; i<DS1820_ROM_SIZE; i++)
     {
-      writeByte(0xcc);
-      writeByte(0xbe);
-      for (int i=0; i<DS1820_SCRATCHPAD_SIZE; i++)
+      writeByte(_rom[index][i]);
+    }
+  }
+  else writeByte(0xcc);
+  return true;
+}
+
+
+// Reads the first size bytes, a reset ends the read early. The whole
+// scratchpad is checked against its CRC.
+uint8_t DS1820::readScratchpad(uint8_t index, uint8_t size)
+{
+  if (select(index)==true)
+  {
+    writeByte(0xbe);
+    for (uint8_t i=0; i<size; i++)
+    {
+      _scratchpad[i] = readByte();
+    }
+    reset();
+    if (size<DS1820_SCRATCHPAD_SIZE) return DS1820_OK;
+    uint8_t crc = 0;
+    for (uint8_t i=0; i<DS1820_SCRATCHPAD_SIZE; i++)
+    {
+      crc = crc8_dallas(crc,_scratchpad[i]);
+    }
+    // All zeroes pass the CRC, but the low configuration bits read 1.
+    if (crc!=0 || (_scratchpad[4]&0x1f)!=0x1f) return DS1820_CRC_ERROR;
+    // The configuration register may have been restored from EEPROM.
+    _resolution = 9 + ((_scratchpad[4]>>5)&0x03);
+    return DS1820_OK;
+  }
+  return DS1820_NO_DEVICE;
+}
+
+
+boolean DS1820::setResolution(uint8_t bits, boolean save)
+{
+  bits = constrain(bits,9,12);
+  // One chip at a time because every chip has its own alarm registers.
+  uint8_t i = _devices==0? DS1820_MAX_DEVICES : 0;
+  do
+  {
+    // Write Scratchpad writes the alarm registers too, keep them.
+    if (readScratchpad(i,DS1820_SCRATCHPAD_SIZE)!=DS1820_OK || select(i)==false) return false;
+    writeByte(0x4e);
+    writeByte(_scratchpad[2]); // TH
+    writeByte(_scratchpad[3]); // TL
+    writeByte(((bits-9)<<5) | 0x1f);
+    if (save==true)
+    {
+      if (select(i)==false) return false;
+      writeByte(0x48);
+      delay(10); // EEPROM write
+    }
+    i++;
+  }
+  while (i<_devices);
+  _resolution = bits;
+  return true;
+}
+
+
+// Search ROM, see Maxim application note 187. Every pass follows the
+// previous ROM code up to its last discrepancy, then takes the 1 branch
+// there and the 0 branch at new discrepancies. Returns the number of
+// chips found.
+uint8_t DS1820::search(void)
+{
+  uint8_t rom[DS1820_ROM_SIZE];
+  uint8_t last = 0; // bit number (1 to 64) of the last 0 branch taken
+  _devices = 0;
+  do
+  {
+    if (reset()==false) break;
+    writeByte(0xf0);
+    uint8_t zero = 0;
+    for (uint8_t bit=1; bit<=8*DS1820_ROM_SIZE; bit++)
+    {
+      uint8_t *p = &rom[(bit-1)>>3];
+      uint8_t mask = 1 << ((bit-1)&0x07);
+      uint8_t a = timeSlot(1);
+      uint8_t b = timeSlot(1);
+      uint8_t direction;
+      if (a!=0 && b!=0) return _devices; // nobody answered
+      if (a!=b) direction = a;
+      else
       {
-        _scratchpad[i] = readByte();
+        // Chips with a 0 and with a 1 here.
+        if (bit<last) direction = (*p&mask)!=0;
+        else direction = bit==last;
+        if (direction==0) zero = bit;
       }
-      reset();
-      result = (_scratchpad[1]*256.0 + _scratchpad[0])/16.0;
+      if (direction!=0) *p |= mask;
+      else *p &= ~mask;
+      timeSlot(direction);
+    }
+    last = zero;
+    uint8_t crc = 0;
+    for (uint8_t i=0; i<DS1820_ROM_SIZE; i++)
+    {
+      crc = crc8_dallas(crc,rom[i]);
     }
+    if (crc!=0) break;
+    memcpy(_rom[_devices],rom,DS1820_ROM_SIZE);
+    _devices++;
   }
-  return result;
+  while (last!=0 && _devices<DS1820_MAX_DEVICES);
+  return _devices;
+}
+
+
+// 94, 188, 375 or 750 ms for 9 to 12 bits.
+uint16_t DS1820::conversionTime(void)
+{
+  uint8_t shift = 12 - _resolution;
+  return (750 + (1<<shift) - 1) >> shift;
 }
@@ -30,30 +30,85 @@
 #define __DS1820_H__
 
 #include "Arduino.h"
+#include "../crc8/crc8.h"
+#include "../onewire/onewire.h"
 
 
-// On the multipurpose shield the chip is connected to PB4 (Arduino pin 12)
-#define DS1820_DQ_DDR  DDRB
-#define DS1820_DQ_PORT  PORTB
-#define DS1820_DQ_PIN  PINB
-#define DS1820_DQ_BIT  4
+// On the multipurpose shield the chip is connected to PB4 (Arduino pin 12),
+// DS1820(void) uses this bus.
+#define DS1820_DEFAULT_PORT  OneWirePortB
+#define DS1820_DEFAULT_BIT  4
 
 
 #define DS1820_SCRATCHPAD_SIZE  9
+#define DS1820_ROM_SIZE  8
+
+// Size of the device table filled by search().
+#define DS1820_MAX_DEVICES  4
+
+// Status codes of the integer functions.
+#define DS1820_OK  0
+#define DS1820_NO_DEVICE  1
+#define DS1820_CRC_ERROR  2
+#define DS1820_TIMEOUT  3
+
+// 9 to 12 bits, 0.5 to 0.0625 degrees.
+#define DS1820_RESOLUTION_DEFAULT  12
 
 
 class DS1820
 {
 public:
-  DS1820(void) {}
-  boolean reset(void);
+  DS1820(void);
+  DS1820(OneWireMaster& bus) : _bus(&bus), _resolution(DS1820_RESOLUTION_DEFAULT), _devices(0), _crcCheck(true) {}
+  boolean reset(void) { return _bus->reset(); }
   float read(void);
 
+  // Non-blocking read: start a conversion, then read the result once
+  // isReady() returns true. A 12-bit conversion takes up to 750 ms.
+  boolean startConversion(void);
+  boolean isReady(void);
+  float readResult(void);
+
+  // Several chips on one bus: search() fills the device table, after
+  // that readResult(index) addresses one chip. startConversion() starts
+  // all of them at once.
+  uint8_t search(void);
+  uint8_t devices(void) { return _devices; }
+  const uint8_t *rom(uint8_t index) { return _rom[index]; }
+  float readResult(uint8_t index);
+  uint8_t readAll(float *result, uint8_t size);
+
+  // Integer versions in hundredths of degrees, returning a status code.
+  // result is 0 in case of an error.
+  uint8_t readCenti(int16_t& result);
+  uint8_t readResultCenti(int16_t& result, uint8_t index=DS1820_MAX_DEVICES);
+
+  // Writes the configuration register of all the chips, save copies it
+  // to their EEPROM. Returns true on success.
+  boolean setResolution(uint8_t bits, boolean save=false);
+  uint8_t resolution(void) { return _resolution; }
+  uint16_t conversionTime(void); // ms
+
+  // With CRC checking results are read from the whole scratchpad,
+  // otherwise only the two temperature bytes are read (2 ms instead of
+  // 5 ms of bus time).
+  void setCrcCheck(boolean check) { _crcCheck = check; }
+
 private:
+  OneWireMaster *_bus;
   uint8_t _scratchpad[DS1820_SCRATCHPAD_SIZE];
-  uint8_t timeSlot(uint8_t value);
-  void writeByte(uint8_t value);
-  uint8_t readByte(void);
+  uint8_t _resolution;
+  uint8_t _rom[DS1820_MAX_DEVICES][DS1820_ROM_SIZE];
+  uint8_t _devices;
+  boolean _crcCheck;
+  boolean select(uint8_t index);
+  uint8_t readScratchpad(uint8_t index, uint8_t size);
+  uint8_t readTemperature(uint8_t index, int16_t& result);
+  boolean waitReady(void);
+  uint8_t timeSlot(uint8_t value) { return _bus->timeSlot(value); }
+  void writeByte(uint8_t value) { _bus->writeByte(value); }
+  uint8_t readByte(void) { return _bus->readByte(); }
 };
 
 
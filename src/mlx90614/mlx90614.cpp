@@ -27,28 +27,141 @@
  */
 
 #include "mlx90614.h"
+#ifndef __MLX90614_ASYNC_TWI__
 #include <Wire.h>
+#endif /* __MLX90614_ASYNC_TWI__ */
+#include "../crc8/crc8.h"
 
 
-const uint8_t crcTable[256] =
+#ifdef __MLX90614_ASYNC_TWI__
+
+// Transfer queue, the interrupt works on the one at the head.
+static MLX90614Transfer *twiQueue[MLX90614_QUEUE_SIZE];
+static volatile uint8_t twiHead;
+static volatile uint8_t twiCount;
+static uint8_t twiRead; // read part of a read word
+static uint8_t twiData[3]; // LSB, MSB, PEC
+static uint8_t twiIndex;
+
+
+static inline void twiContinue(void)
+{
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+}
+
+
+static inline void twiAck(void)
 {
-    0,   7,  14,   9,  28,  27,  18,  21,  56,  63,  54,  49,  36,  35,  42,  45,
-  112, 119, 126, 121, 108, 107,  98, 101,  72,  79,  70,  65,  84,  83,  90,  93,
-  224, 231, 238, 233, 252, 251, 242, 245, 216, 223, 214, 209, 196, 195, 202, 205,
-  144, 151, 158, 153, 140, 139, 130, 133, 168, 175, 166, 161, 180, 179, 186, 189,
-  199, 192, 201, 206, 219, 220, 213, 210, 255, 248, 241, 246, 227, 228, 237, 234,
-  183, 176, 185, 190, 171, 172, 165, 162, 143, 136, 129, 134, 147, 148, 157, 154,
-   39,  32,  41,  46,  59,  60,  53,  50,  31,  24,  17,  22,   3,   4,  13,  10,
-   87,  80,  89,  94,  75,  76,  69,  66, 111, 104,  97, 102, 115, 116, 125, 122,
-  137, 142, 135, 128, 149, 146, 155, 156, 177, 182, 191, 184, 173, 170, 163, 164,
-  249, 254, 247, 240, 229, 226, 235, 236, 193, 198, 207, 200, 221, 218, 211, 212,
-  105, 110, 103,  96, 117, 114, 123, 124,  81,  86,  95,  88,  77,  74,  67,  68,
-   25,  30,  23,  16,   5,   2,  11,  12,  33,  38,  47,  40,  61,  58,  51,  52,
-   78,  73,  64,  71,  82,  85,  92,  91, 118, 113, 120, 127, 106, 109, 100,  99,
-   62,  57,  48,  55,  34,  37,  44,  43,   6,   1,   8,  15,  26,  29,  20,  19,
-  174, 169, 160, 167, 178, 181, 188, 187, 150, 145, 152, 159, 138, 141, 132, 131,
-  222, 217, 208, 215, 194, 197, 204, 203, 230, 225, 232, 239, 250, 253, 244, 243
-};
+  TWCR = _BV(TWINT) | _BV(TWEA) | _BV(TWEN) | _BV(TWIE);
+}
+
+
+static inline void twiStart(void)
+{
+  twiRead = 0;
+  TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+}
+
+
+static inline void twiWaitStop(void)
+{
+  while ((TWCR&_BV(TWSTO))!=0);
+}
+
+
+// Completes the transfer at the head. The next one follows after a
+// repeated start, or the bus is released.
+static void twiDone(uint8_t status)
+{
+  MLX90614Transfer *t = twiQueue[twiHead];
+  if (status==MLX90614_OK && t->write==false)
+  {
+    uint8_t crc = crc8_smbus(0,MLX90614_ADDRESS<<1);
+    crc = crc8_smbus(crc,t->command);
+    crc = crc8_smbus(crc,(MLX90614_ADDRESS<<1)|0x01);
+    crc = crc8_smbus(crc,twiData[0]);
+    crc = crc8_smbus(crc,twiData[1]);
+    if (crc==twiData[2]) t->value = (twiData[1]<<8) | twiData[0];
+    else status = MLX90614_PEC_ERROR;
+  }
+  t->status = status;
+  twiHead = (twiHead+1) % MLX90614_QUEUE_SIZE;
+  twiCount--;
+  if (twiCount!=0 && status!=MLX90614_BUS_ERROR)
+  {
+    twiStart();
+    return;
+  }
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+  if (twiCount!=0)
+  {
+    twiWaitStop();
+    twiStart();
+  }
+}
+
+
+ISR(TWI_vect)
+{
+  MLX90614Transfer *t = twiQueue[twiHead];
+  switch (TWSR & 0xf8)
+  {
+    case 0x08: // start
+    case 0x10: // repeated start
+      TWDR = (MLX90614_ADDRESS<<1) | twiRead;
+      twiContinue();
+      break;
+
+    case 0x18: // address + write acknowledged
+      TWDR = t->command;
+      twiIndex = 0;
+      if (t->write==true)
+      {
+        twiData[0] = t->value & 0xff;
+        twiData[1] = t->value >> 8;
+        twiData[2] = crc8_smbus(crc8_smbus(crc8_smbus(crc8_smbus(0,MLX90614_ADDRESS<<1),t->command),twiData[0]),twiData[1]);
+      }
+      twiContinue();
+      break;
+
+    case 0x28: // data byte acknowledged
+      if (t->write==false)
+      {
+        twiRead = 1;
+        TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN) | _BV(TWIE);
+      }
+      else if (twiIndex<3)
+      {
+        TWDR = twiData[twiIndex++];
+        twiContinue();
+      }
+      else twiDone(MLX90614_OK);
+      break;
+
+    case 0x40: // address + read acknowledged
+      twiIndex = 0;
+      twiAck();
+      break;
+
+    case 0x50: // data byte received, acknowledge sent
+      twiData[twiIndex++] = TWDR;
+      // Not acknowledging the PEC ends the read.
+      if (twiIndex<2) twiAck();
+      else twiContinue();
+      break;
+
+    case 0x58: // PEC received
+      twiData[2] = TWDR;
+      twiDone(MLX90614_OK);
+      break;
+
+    default: // no acknowledge, arbitration lost or bus error
+      twiDone(MLX90614_BUS_ERROR);
+      break;
+  }
+}
+
+#endif /* __MLX90614_ASYNC_TWI__ */
 
 
 MLX90614::MLX90614(void)
@@ -65,40 +178,241 @@ void MLX90614::begin(uint8_t sdaPin, uint8_t sclPin)
   _scl = sclPin;
   pinMode(_sda,INPUT_PULLUP);
   pinMode(_scl,INPUT_PULLUP);
-  Wire.begin(MLX90614_ADDRESS);
+#ifdef __MLX90614_ASYNC_TWI__
+  TWSR = 0; // prescaler 1
+  TWBR = ((F_CPU/MLX90614_TWI_FREQUENCY)-16)/2;
+  TWCR = _BV(TWEN);
+#else
+  // As master, the address would make us a slave.
+  Wire.begin();
+#endif /* __MLX90614_ASYNC_TWI__ */
 }
 
 
 void MLX90614::crcUpdate(uint8_t value)
 { 
-  _crc = crcTable[value^_crc];
+  _crc = crc8_smbus(_crc,value);
 }
 
 
 uint16_t MLX90614::readRaw(void) 
 { 
-  uint16_t value = 0; 
-  uint8_t pec = 0; 
+  uint16_t value;
+  if (readWord(MLX90614_READ_TEMPERATURE,value)!=MLX90614_OK) return 0;
+  return value&0x7fff;
+}   
+
+
+uint8_t MLX90614::readCenti(int16_t& result)
+{
+  uint16_t value;
+  result = 0;
+  uint8_t status = readWord(MLX90614_READ_TEMPERATURE,value);
+  if (status!=MLX90614_OK) return status;
+  return convertCenti(value,result);
+}
+
+
+uint8_t MLX90614::convertCenti(uint16_t value, int16_t& result)
+{
+  result = 0;
+  if ((value&0x8000)!=0) return MLX90614_FLAG_ERROR;
+  // 0.02 K per bit, saturates above 327 degrees.
+  int32_t t = 2*(int32_t)value - 27315;
+  result = t>32767? 32767 : t;
+  return MLX90614_OK;
+}
+
+
+#ifdef __MLX90614_ASYNC_TWI__
+
+uint8_t MLX90614::readWord(uint8_t command, uint16_t& value, boolean stop)
+{
+  // The queue decides about stop conditions.
+  (void)stop;
+  MLX90614Transfer t = { command, false, 0, MLX90614_OK };
+  uint8_t status = transfer(t);
+  value = status==MLX90614_OK? t.value : 0;
+  return status;
+}
+
+
+uint8_t MLX90614::readAll(MLX90614Temperatures& result)
+{
+  MLX90614Transfer t[3] =
+  {
+    { MLX90614_RAM_AMBIENT, false, 0, MLX90614_OK },
+    { MLX90614_RAM_OBJECT1, false, 0, MLX90614_OK },
+    { MLX90614_RAM_OBJECT2, false, 0, MLX90614_OK },
+  };
+  uint8_t i;
+  for (i=0; i<3; i++)
+  {
+    while (submit(t[i])==true);
+  }
+  for (i=0; i<3; i++)
+  {
+    while (t[i].status==MLX90614_BUSY);
+  }
+  result.ambient = t[0].value;
+  result.object1 = t[1].value;
+  result.object2 = t[2].value;
+  for (i=0; i<3; i++)
+  {
+    if (t[i].status!=MLX90614_OK) return t[i].status;
+  }
+  return MLX90614_OK;
+}
+
+
+uint8_t MLX90614::writeWord(uint8_t command, uint16_t value)
+{
+  MLX90614Transfer t = { command, true, value, MLX90614_OK };
+  return transfer(t);
+}
+
+
+boolean MLX90614::submit(MLX90614Transfer& transfer)
+{
+  boolean full;
+  uint8_t sreg = SREG;
+  cli();
+  full = twiCount>=MLX90614_QUEUE_SIZE;
+  if (full==false)
+  {
+    transfer.status = MLX90614_BUSY;
+    twiQueue[(twiHead+twiCount)%MLX90614_QUEUE_SIZE] = &transfer;
+    twiCount++;
+    if (twiCount==1)
+    {
+      twiWaitStop();
+      twiStart();
+    }
+  }
+  SREG = sreg;
+  return full;
+}
+
+
+// Blocking transfer.
+uint8_t MLX90614::transfer(MLX90614Transfer& transfer)
+{
+  while (submit(transfer)==true);
+  while (transfer.status==MLX90614_BUSY);
+  return transfer.status;
+}
+
+#else
+
+uint8_t MLX90614::readWord(uint8_t command, uint16_t& value, boolean stop)
+{ 
+  uint8_t pec;
   uint8_t lsb; 
   uint8_t msb; 
 
-  // Read temperature register.
+  value = 0;
   Wire.beginTransmission(MLX90614_ADDRESS); 
-  Wire.write(MLX90614_READ_TEMPERATURE); 
+  Wire.write(command); 
   // Restart without sending a stop condition.
-  Wire.endTransmission(false); 
-  Wire.requestFrom(MLX90614_ADDRESS,3,true); 
-  if (Wire.available()!=0) lsb = Wire.read();
-  if (Wire.available()!=0) msb = Wire.read();
-  if (Wire.available()!=0) pec = Wire.read();
-  Wire.endTransmission(true); 
+  if (Wire.endTransmission(false)!=0) return MLX90614_BUS_ERROR;
+  if (Wire.requestFrom(MLX90614_ADDRESS,3,stop)!=3) return MLX90614_BUS_ERROR;
+  lsb = Wire.read();
+  msb = Wire.read();
+  pec = Wire.read();
 
   _crc = 0;
   crcUpdate(MLX90614_ADDRESS<<1);
-  crcUpdate(MLX90614_READ_TEMPERATURE);
+  crcUpdate(command);
   crcUpdate((MLX90614_ADDRESS<<1)|0x01);
   crcUpdate(lsb);
   crcUpdate(msb);
-  if (pec==_crc) value = ((msb&0x7f)<<8) + lsb;
-  return value; 
-}   
+  if (pec!=_crc) return MLX90614_PEC_ERROR;
+  value = (msb<<8) + lsb;
+  return MLX90614_OK;
+}
+
+
+uint8_t MLX90614::readAll(MLX90614Temperatures& result)
+{
+  // Tobj1 is skipped when Ta fails.
+  memset(&result,0,sizeof(result));
+  uint8_t status = readWord(MLX90614_RAM_AMBIENT,result.ambient,false);
+  if (status==MLX90614_OK) status = readWord(MLX90614_RAM_OBJECT1,result.object1,false);
+  // The last read ends with a stop, also after an error.
+  uint8_t status2 = readWord(MLX90614_RAM_OBJECT2,result.object2,true);
+  return status!=MLX90614_OK? status : status2;
+}
+
+
+uint8_t MLX90614::writeWord(uint8_t command, uint16_t value)
+{
+  _crc = 0;
+  crcUpdate(MLX90614_ADDRESS<<1);
+  crcUpdate(command);
+  crcUpdate(value&0xff);
+  crcUpdate(value>>8);
+  Wire.beginTransmission(MLX90614_ADDRESS);
+  Wire.write(command);
+  Wire.write(value&0xff);
+  Wire.write(value>>8);
+  Wire.write(_crc);
+  if (Wire.endTransmission(true)!=0) return MLX90614_BUS_ERROR;
+  return MLX90614_OK;
+}
+
+#endif /* __MLX90614_ASYNC_TWI__ */
+
+
+uint8_t MLX90614::writeEeprom(uint8_t address, uint16_t value)
+{
+  uint8_t command = MLX90614_EEPROM | address;
+  uint16_t check;
+  // A cell must be erased by writing 0 first.
+  uint8_t status = writeWord(command,0);
+  if (status!=MLX90614_OK) return status;
+  delay(MLX90614_EEPROM_WRITE_TIME);
+  status = writeWord(command,value);
+  if (status!=MLX90614_OK) return status;
+  delay(MLX90614_EEPROM_WRITE_TIME);
+  status = readWord(command,check);
+  if (status==MLX90614_OK && check!=value) status = MLX90614_EEPROM_ERROR;
+  return status;
+}
+
+
+uint8_t MLX90614::readEmissivity(uint16_t& value)
+{
+  return readWord(MLX90614_EEPROM|MLX90614_EEPROM_EMISSIVITY,value);
+}
+
+
+uint8_t MLX90614::setEmissivity(uint16_t value)
+{
+  uint16_t old;
+  uint8_t status = readEmissivity(old);
+  if (status!=MLX90614_OK || old==value) return status;
+  return writeEeprom(MLX90614_EEPROM_EMISSIVITY,value);
+}
+
+
+// Config register 1: IIR in bits 0-2, FIR in bits 8-10.
+uint8_t MLX90614::readFilter(uint8_t& iir, uint8_t& fir)
+{
+  uint16_t config;
+  uint8_t status = readWord(MLX90614_EEPROM|MLX90614_EEPROM_CONFIG1,config);
+  iir = config & 0x07;
+  fir = (config>>8) & 0x07;
+  return status;
+}
+
+
+uint8_t MLX90614::setFilter(uint8_t iir, uint8_t fir)
+{
+  uint16_t config;
+  uint8_t status = readWord(MLX90614_EEPROM|MLX90614_EEPROM_CONFIG1,config);
+  if (status!=MLX90614_OK) return status;
+  // The other bits hold factory settings, keep them.
+  uint16_t value = (config & ~0x0707) | ((fir&0x07)<<8) | (iir&0x07);
+  if (value==config) return MLX90614_OK;
+  return writeEeprom(MLX90614_EEPROM_CONFIG1,value);
+}
@@ -32,9 +32,58 @@
 #include "Arduino.h"
 
 
+// Drive the TWI hardware from its interrupt instead of through Wire, so
+// transfers run in the background. Wire can no longer be used, both
+// handle the TWI interrupt.
+//#define __MLX90614_ASYNC_TWI__
+
+
 #define MLX90614_ADDRESS  (0x5a)
 #define MLX90614_READ_TEMPERATURE  (0x07)
 
+// RAM registers.
+#define MLX90614_RAM_AMBIENT  (0x06)
+#define MLX90614_RAM_OBJECT1  (0x07)
+#define MLX90614_RAM_OBJECT2  (0x08)
+
+// EEPROM cells, or them with MLX90614_EEPROM in commands.
+#define MLX90614_EEPROM  (0x20)
+#define MLX90614_EEPROM_EMISSIVITY  (0x04)
+#define MLX90614_EEPROM_CONFIG1  (0x05)
+#define MLX90614_EEPROM_WRITE_TIME  10 /* ms, 5 minimum */
+
+// Status codes of the integer functions.
+#define MLX90614_OK  0
+#define MLX90614_BUS_ERROR  1
+#define MLX90614_PEC_ERROR  2
+#define MLX90614_FLAG_ERROR  3 /* bit 15 set by the sensor */
+#define MLX90614_EEPROM_ERROR  4 /* read back differs */
+#define MLX90614_BUSY  0xff /* transfer queued or in progress */
+
+#define MLX90614_QUEUE_SIZE  4
+#define MLX90614_TWI_FREQUENCY  100000 /* Hz, SMBus */
+
+
+// Raw values in 0.02 K.
+struct MLX90614Temperatures
+{
+  uint16_t ambient;
+  uint16_t object1;
+  uint16_t object2;
+};
+
+
+// SMBus read or write word for submit(). The status is MLX90614_BUSY
+// until the transfer is done, then value holds the PEC-checked result of
+// a read.
+struct MLX90614Transfer
+{
+  uint8_t command;
+  boolean write;
+  uint16_t value;
+  volatile uint8_t status;
+};
+
 
 class MLX90614
 {
@@ -44,12 +93,44 @@ public:
   void begin(uint8_t sdaPin, uint8_t sclPin);
   uint16_t readRaw(void);
   float read(void) { return 0.02*(float)readRaw() - 273.15; }   
+  // Hundredths of degrees, result is 0 in case of an error.
+  uint8_t readCenti(int16_t& result);
+  // The same from a raw temperature word, e.g. of a submitted transfer.
+  static uint8_t convertCenti(uint16_t value, int16_t& result);
+
+  // PEC-checked SMBus read word. Without a stop the next read starts with
+  // a repeated start.
+  uint8_t readWord(uint8_t command, uint16_t& value, boolean stop=true);
+  // Ta, Tobj1 and Tobj2 without releasing the bus in between.
+  uint8_t readAll(MLX90614Temperatures& result);
+
+#ifdef __MLX90614_ASYNC_TWI__
+  // Queues a transfer, returns true if the queue is full. The transfer
+  // must stay in memory until it is done. Transfers queued back to back
+  // are joined by repeated starts.
+  boolean submit(MLX90614Transfer& transfer);
+#endif /* __MLX90614_ASYNC_TWI__ */
+
+  // EEPROM settings, the sensor loads them at power-on. Writing an
+  // unchanged value is skipped to spare the EEPROM.
+  // Emissivity is 65535 for 1.0.
+  uint8_t readEmissivity(uint16_t& value);
+  uint8_t setEmissivity(uint16_t value);
+  // IIR 4 is off, 5, 6, 7, 0, 1, 2, 3 filter more and more. FIR 4 to 7
+  // is 128 to 1024 taps. Stronger filtering is slower but less noisy.
+  uint8_t readFilter(uint8_t& iir, uint8_t& fir);
+  uint8_t setFilter(uint8_t iir, uint8_t fir);
   
 private:
   uint8_t _sda;
   uint8_t _scl;
   uint8_t _crc;
   void crcUpdate(uint8_t value);
+  uint8_t writeWord(uint8_t command, uint16_t value);
+  uint8_t writeEeprom(uint8_t address, uint16_t value);
+#ifdef __MLX90614_ASYNC_TWI__
+  uint8_t transfer(MLX90614Transfer& transfer);
+#endif /* __MLX90614_ASYNC_TWI__ */
 };
 
 
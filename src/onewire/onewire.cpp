@@ -0,0 +1,50 @@
+/*
+ * One-wire bus master.
+ *
+ * Belongs to:
+ * "Mastering Microcontrollers Helped by Arduino"
+ * ISBN 978-1-907920-23-3 (English)
+ * ISBN 978-2-86661-190-3 (French)
+ * ISBN 978-3-89576-296-3 (German)
+ * http://www.polyvalens.com/
+ *
+ * For use with PolyValens Multipurpose Shield 129009-1
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#include "onewire.h"
+
+
+// LSB first.
+void OneWireMaster::writeByte(uint8_t value)
+{
+  for (uint8_t mask=0x01; mask!=0; mask<<=1)
+  {
+    timeSlot(value&mask);
+  }
+}
+
+
+uint8_t OneWireMaster::readByte(void)
+{
+  uint8_t result = 0;
+  for (uint8_t mask=0x01; mask!=0; mask<<=1)
+  {
+    if (timeSlot(1)!=0) result |= mask;
+  }
+  return result;
+}
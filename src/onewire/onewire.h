@@ -0,0 +1,131 @@
+/*
+ * One-wire bus master.
+ *
+ * Belongs to:
+ * "Mastering Microcontrollers Helped by Arduino"
+ * ISBN 978-1-907920-23-3 (English)
+ * ISBN 978-2-86661-190-3 (French)
+ * ISBN 978-3-89576-296-3 (German)
+ * http://www.polyvalens.com/
+ *
+ * For use with PolyValens Multipurpose Shield 129009-1
+ *
+ * Copyright (c) 2015, Clemens Valens
+ *
+ * Permission to use, copy, modify, and/or distribute this software for
+ * any purpose with or without fee is hereby granted, provided that the
+ * above copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL
+ * WARRANTIES WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR
+ * BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES
+ * OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS,
+ * WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS
+ * SOFTWARE.
+ */
+
+#ifndef __ONEWIRE_H__
+#define __ONEWIRE_H__
+
+#include "Arduino.h"
+
+
+// Bus master, the devices only see reset pulses and time slots.
+class OneWireMaster
+{
+public:
+  // Returns true if a device answered with a presence pulse.
+  virtual boolean reset(void) = 0;
+  // Writes a bit, a 1 is also a read slot. Returns the bus level.
+  virtual uint8_t timeSlot(uint8_t value) = 0;
+
+  void writeByte(uint8_t value);
+  uint8_t readByte(void);
+};
+
+
+// Port registers for OneWireBus. A mock port for tests only needs the
+// same three functions returning variables, of any type with the
+// register operators.
+#define ONEWIRE_PORT(name,ddr,port,pin) \
+  struct name \
+  { \
+    static inline auto DDR(void) -> decltype((ddr)) { return ddr; } \
+    static inline auto PORT(void) -> decltype((port)) { return port; } \
+    static inline auto PIN(void) -> decltype((pin)) { return pin; } \
+  }
+
+#ifdef PORTB
+ONEWIRE_PORT(OneWirePortB,DDRB,PORTB,PINB);
+#endif
+#ifdef PORTC
+ONEWIRE_PORT(OneWirePortC,DDRC,PORTC,PINC);
+#endif
+#ifdef PORTD
+ONEWIRE_PORT(OneWirePortD,DDRD,PORTD,PIND);
+#endif
+
+
+// A bus on a port bit known at compile time, every access compiles to a
+// single sbi/cbi/sbic. Every instance is an independent bus.
+template <class Port, uint8_t Bit>
+class OneWireBus : public OneWireMaster
+{
+public:
+  virtual boolean reset(void)
+  {
+    boolean presence = false;
+    low();
+    delayMicroseconds(500);
+    release();
+    int timeout = 480;
+    int dt = 30;
+    while (timeout>0)
+    {
+      delayMicroseconds(dt);
+      timeout -= dt;
+      if (level()==0)
+      {
+        presence = true;
+        break;
+      }
+    }
+    // Finish timeout.
+    delayMicroseconds(timeout);
+    return presence;
+  }
+
+  virtual uint8_t timeSlot(uint8_t value)
+  {
+    uint8_t result = 0;
+    low();
+    delayMicroseconds(2);
+    if (value!=0) release();
+    delayMicroseconds(10);
+    if (level()!=0) result = 1;
+    delayMicroseconds(50);
+    release();
+    return result;
+  }
+
+private:
+  static inline void low(void)
+  {
+    Port::DDR() |= _BV(Bit);
+    Port::PORT() &= ~_BV(Bit);
+  }
+
+  // The pull-up resistor pulls the bus high.
+  static inline void release(void)
+  {
+    Port::PORT() |= _BV(Bit);
+    Port::DDR() &= ~_BV(Bit);
+  }
+
+  static inline uint8_t level(void) { return Port::PIN() & _BV(Bit); }
+};
+
+
+#endif /* __ONEWIRE_H__ */